@@ -0,0 +1,97 @@
+#include <y3c/algorithm.h>
+#include <y3c/vector.h>
+#include <algorithm>
+#include <vector>
+#include "bench.h"
+
+/*
+ * y3c/algorithm と、生ポインタに対するstd::のアルゴリズムの比較。
+ * (std::sort などは要素の参照が wrap<T&> になる y3c のイテレータを受け付けないので、
+ * y3c::vector のイテレータに対しては std::copy のみ比較する)
+ */
+int main() {
+    const int n = 10000;
+    std::vector<int> shuffled(n);
+    for (int i = 0; i < n; i++) {
+        shuffled[i] = static_cast<int>((i * 7919L) % n);
+    }
+    y3c::vector<int> v(shuffled.begin(), shuffled.end());
+    y3c::vector<int> w(n);
+    std::vector<int> s(shuffled), t(n);
+
+    y3c_bench::run("std::sort (pointer)", 100, [&] {
+        std::copy(shuffled.begin(), shuffled.end(), s.begin());
+        std::sort(s.data(), s.data() + n);
+        return s[0];
+    });
+    y3c_bench::run("y3c::sort", 100, [&] {
+        v = shuffled;
+        y3c::sort(v.begin(), v.end());
+        return y3c::unwrap(v[0]);
+    });
+    y3c_bench::run("std::copy (pointer)", 1000, [&] {
+        std::copy(s.data(), s.data() + n, t.data());
+        return t[n - 1];
+    });
+    y3c_bench::run("y3c::copy", 1000, [&] {
+        y3c::copy(v.begin(), v.end(), w.begin());
+        return y3c::unwrap(w[n - 1]);
+    });
+    y3c_bench::run("std::copy (y3c::vector)", 100, [&] {
+        std::copy(v.begin(), v.end(), w.begin());
+        return y3c::unwrap(w[n - 1]);
+    });
+
+    // イテレータが生きている状態のvectorへの追加
+    y3c_bench::run("std::back_inserter (pointer)", 100, [&] {
+        std::vector<int> d(1);
+        std::copy(s.data(), s.data() + n, std::back_inserter(d));
+        return d.size();
+    });
+    y3c_bench::run("std::copy (y3c::back_inserter)", 100, [&] {
+        y3c::vector<int> d(1);
+        auto first = d.begin();
+        std::copy(s.data(), s.data() + n, y3c::back_inserter(d));
+        return d.size();
+    });
+    y3c_bench::run("y3c::copy (y3c::back_inserter)", 100, [&] {
+        y3c::vector<int> d(1);
+        auto first = d.begin();
+        y3c::copy(v.begin(), v.end(), y3c::back_inserter(d));
+        return d.size();
+    });
+
+    y3c_bench::run("erase(remove_if) (y3c::vector)", 100, [&] {
+        y3c::vector<int> d = v;
+        d.erase(std::remove_if(d.begin(), d.end(),
+                               [](int x) { return x % 2 == 0; }),
+                d.end());
+        return d.size();
+    });
+    y3c_bench::run("y3c::erase_if", 100, [&] {
+        y3c::vector<int> d = v;
+        y3c::erase_if(d, [](int x) { return x % 2 == 0; });
+        return d.size();
+    });
+    y3c_bench::run("y3c::vector::append_range", 100, [&] {
+        y3c::vector<int> d(1);
+        auto first = d.begin();
+        d.append_range(v);
+        return d.size();
+    });
+
+    y3c_bench::run("std::find (pointer)", 1000, [&] {
+        return std::find(s.data(), s.data() + n, n - 1) - s.data();
+    });
+    y3c_bench::run("y3c::find", 1000, [&] {
+        return y3c::find(v.begin(), v.end(), n - 1) - v.begin();
+    });
+
+    y3c_bench::run("std::lower_bound (pointer)", 100000, [&] {
+        return std::lower_bound(s.data(), s.data() + n, n / 3) - s.data();
+    });
+    y3c_bench::run("y3c::lower_bound", 100000, [&] {
+        return y3c::lower_bound(v.begin(), v.end(), n / 3) - v.begin();
+    });
+    return 0;
+}
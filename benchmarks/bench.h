@@ -0,0 +1,25 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+
+namespace y3c_bench {
+/*!
+ * \brief 処理を繰り返し実行し、1回あたりの時間を表示する
+ *
+ * 最適化で消されないよう、fは何らかの値を返し、それを合計して表示する。
+ *
+ */
+template <typename F>
+void run(const char *name, long iterations, F f) {
+    auto start = std::chrono::steady_clock::now();
+    long sink = 0;
+    for (long i = 0; i < iterations; i++) {
+        sink += static_cast<long>(f());
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns =
+        std::chrono::duration<double, std::nano>(end - start).count() /
+        static_cast<double>(iterations);
+    std::printf("%-32s %10.2f ns/iter (%ld)\n", name, ns, sink);
+}
+} // namespace y3c_bench
@@ -0,0 +1,110 @@
+#include <y3c/vector.h>
+#include <y3c/array.h>
+#include <y3c/wrap.h>
+#include <y3c/shared_ptr.h>
+#include "bench.h"
+
+/*
+ * チェックレベルごとのコストの計測。
+ * Y3C_CHECK_LEVEL を変えてビルドしたものを比較する。
+ */
+int main() {
+    std::printf("Y3C_CHECK_LEVEL = %d\n", Y3C_CHECK_LEVEL);
+
+    y3c::vector<int> v(1000, 1);
+    y3c_bench::run("vector::operator[]", 1000, [&] {
+        int sum = 0;
+        for (std::size_t i = 0; i < v.size(); i++) {
+            sum += y3c::unwrap(v[i]);
+        }
+        return sum;
+    });
+    y3c_bench::run("vector::iterator", 1000, [&] {
+        int sum = 0;
+        for (auto it = v.begin(); it != v.end(); ++it) {
+            sum += y3c::unwrap(*it);
+        }
+        return sum;
+    });
+    y3c_bench::run("vector::reverse_iterator", 1000, [&] {
+        int sum = 0;
+        for (auto it = v.rbegin(); it != v.rend(); ++it) {
+            sum += y3c::unwrap(*it);
+        }
+        return sum;
+    });
+    y3c_bench::run("y3c::range(vector)", 1000, [&] {
+        int sum = 0;
+        for (int x : y3c::range(v)) {
+            sum += x;
+        }
+        return sum;
+    });
+    y3c_bench::run("vector::pin()::operator[]", 1000, [&] {
+        auto p = v.pin();
+        int sum = 0;
+        for (std::size_t i = 0; i < p.size(); i++) {
+            sum += p[i];
+        }
+        return sum;
+    });
+    y3c_bench::run("std::vector (baseline)", 1000, [&] {
+        int sum = 0;
+        for (int x : y3c::unwrap(v)) {
+            sum += x;
+        }
+        return sum;
+    });
+    y3c_bench::run("vector::push_back", 1000, [&] {
+        y3c::vector<int> w;
+        for (int i = 0; i < 1000; i++) {
+            w.push_back(i);
+        }
+        return w.size();
+    });
+    y3c_bench::run("push_back (iterator held)", 1000, [&] {
+        y3c::vector<int> w;
+        w.reserve(1001);
+        w.push_back(0);
+        auto it = w.begin();
+        for (int i = 0; i < 1000; i++) {
+            w.push_back(i);
+        }
+        return w.size() + (it == w.begin());
+    });
+    y3c_bench::run("push_back (batch)", 1000, [&] {
+        y3c::vector<int> w;
+        w.reserve(1001);
+        w.push_back(0);
+        auto it = w.begin();
+        auto tx = w.batch();
+        for (int i = 0; i < 1000; i++) {
+            w.push_back(i);
+        }
+        return w.size() + (it == w.begin());
+    });
+    y3c::array<int, 1000> a;
+    a.fill(1);
+    y3c_bench::run("array::operator[]", 1000, [&] {
+        int sum = 0;
+        for (std::size_t i = 0; i < a.size(); i++) {
+            sum += y3c::unwrap(a[i]);
+        }
+        return sum;
+    });
+    y3c::wrap<int[1000]> w;
+    for (int &x : y3c::unwrap(w)) {
+        x = 1;
+    }
+    y3c_bench::run("wrap<int[]>::operator[]", 1000, [&] {
+        int sum = 0;
+        for (std::size_t i = 0; i < 1000; i++) {
+            sum += y3c::unwrap(w[i]);
+        }
+        return sum;
+    });
+    y3c::shared_ptr<int> p = y3c::make_shared<int>(1);
+    y3c_bench::run("shared_ptr::operator*", 1000000,
+                   [&] { return y3c::unwrap(*p); });
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include <y3c/numeric.h>
+#include <y3c/vector.h>
+#include <numeric>
+#include <vector>
+#include "bench.h"
+
+/*
+ * y3c/numeric と、生ポインタに対するstd::の関数、
+ * y3c::vector のイテレータでの1要素ずつのループの比較。
+ */
+int main() {
+    const int n = 10000;
+    std::vector<double> s(n), t(n);
+    for (int i = 0; i < n; i++) {
+        s[i] = i * 0.5;
+        t[i] = (n - i) * 0.25;
+    }
+    y3c::vector<double> v(s.begin(), s.end());
+    y3c::vector<double> w(t.begin(), t.end());
+
+    y3c_bench::run("std::accumulate (pointer)", 1000, [&] {
+        return std::accumulate(s.data(), s.data() + n, 0.0);
+    });
+    y3c_bench::run("y3c::accumulate", 1000, [&] {
+        return y3c::accumulate(v.begin(), v.end(), 0.0);
+    });
+    y3c_bench::run("iterator loop sum", 100, [&] {
+        double sum = 0;
+        for (auto it = v.begin(); it != v.end(); ++it) {
+            sum += y3c::unwrap(*it);
+        }
+        return sum;
+    });
+
+    y3c_bench::run("std::inner_product (pointer)", 1000, [&] {
+        return std::inner_product(s.data(), s.data() + n, t.data(), 0.0);
+    });
+    y3c_bench::run("y3c::inner_product", 1000, [&] {
+        return y3c::inner_product(v.begin(), v.end(), w.begin(), 0.0);
+    });
+    y3c_bench::run("y3c::transform_reduce", 1000, [&] {
+        return y3c::transform_reduce(v.begin(), v.end(), w.begin(), 0.0);
+    });
+    return 0;
+}
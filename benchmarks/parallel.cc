@@ -0,0 +1,43 @@
+#include <y3c/parallel.h>
+#include <y3c/algorithm.h>
+#include <y3c/numeric.h>
+#include <y3c/vector.h>
+#include <vector>
+#include "bench.h"
+
+/*
+ * y3c::parallel と、1スレッドで実行する y3c/algorithm, y3c/numeric の比較。
+ * スレッド数は環境変数 Y3C_THREADS で変えられる。
+ */
+int main() {
+    const int n = 1000000;
+    std::vector<int> shuffled(n);
+    for (int i = 0; i < n; i++) {
+        shuffled[i] = static_cast<int>((i * 7919L) % n);
+    }
+    y3c::vector<int> v(shuffled.begin(), shuffled.end());
+    std::printf("threads: %zu\n",
+                y3c::internal::thread_pool::instance().size());
+
+    y3c_bench::run("y3c::sort", 10, [&] {
+        v = shuffled;
+        y3c::sort(v.begin(), v.end());
+        return y3c::unwrap(v[0]);
+    });
+    y3c_bench::run("y3c::parallel::sort", 10, [&] {
+        v = shuffled;
+        y3c::parallel::sort(v.begin(), v.end());
+        return y3c::unwrap(v[0]);
+    });
+    y3c_bench::run("y3c::accumulate", 100, [&] {
+        return y3c::accumulate(v.begin(), v.end(), 0L);
+    });
+    y3c_bench::run("y3c::parallel::reduce", 100, [&] {
+        return y3c::parallel::reduce(v.begin(), v.end(), 0L);
+    });
+    y3c_bench::run("y3c::parallel::for_each", 100, [&] {
+        y3c::parallel::for_each(v.begin(), v.end(), [](int &x) { x ^= 1; });
+        return y3c::unwrap(v[0]);
+    });
+    return 0;
+}
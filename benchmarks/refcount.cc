@@ -0,0 +1,32 @@
+#include <y3c/vector.h>
+#include "bench.h"
+
+/*
+ * observerのコピー (参照カウントの増減) が多い操作の計測。
+ * Y3C_SINGLE_THREADED=0 と 1 でビルドしたものを比較する。
+ */
+int main() {
+    std::printf("Y3C_SINGLE_THREADED = %d\n", Y3C_SINGLE_THREADED);
+
+    y3c::vector<int> v(1000, 1);
+    y3c_bench::run("vector::operator[]", 1000, [&] {
+        int sum = 0;
+        for (std::size_t i = 0; i < v.size(); i++) {
+            sum += y3c::unwrap(v[i]);
+        }
+        return sum;
+    });
+    y3c_bench::run("vector::iterator", 1000, [&] {
+        int sum = 0;
+        for (auto it = v.begin(); it != v.end(); ++it) {
+            sum += y3c::unwrap(*it);
+        }
+        return sum;
+    });
+    y3c_bench::run("vector::iterator copy", 1000000, [&] {
+        auto it = v.begin();
+        auto copy = it;
+        return y3c::unwrap(copy) - y3c::unwrap(it);
+    });
+    return 0;
+}
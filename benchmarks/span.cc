@@ -0,0 +1,60 @@
+#include <y3c/span.h>
+#include <y3c/vector.h>
+#include <vector>
+#include "bench.h"
+
+/*
+ * 関数に y3c::vector の参照、イテレータの組、y3c::span を渡して
+ * 要素を読む場合の比較。
+ */
+static long sum_vector(const y3c::vector<int> &v) {
+    long total = 0;
+    for (std::size_t i = 0; i < v.size(); i++) {
+        total += y3c::unwrap(v[i]);
+    }
+    return total;
+}
+static long sum_iter(y3c::vector<int>::const_iterator first,
+                     y3c::vector<int>::const_iterator last) {
+    long total = 0;
+    for (; first != last; ++first) {
+        total += y3c::unwrap(*first);
+    }
+    return total;
+}
+static long sum_span(y3c::span<const int> s) {
+    long total = 0;
+    for (std::size_t i = 0; i < s.size(); i++) {
+        total += y3c::unwrap(s[i]);
+    }
+    return total;
+}
+static long sum_span_range(y3c::span<const int> s) {
+    long total = 0;
+    for (const int &x : y3c::range(s)) {
+        total += x;
+    }
+    return total;
+}
+
+int main() {
+    const int n = 10000;
+    std::vector<int> s(n, 1);
+    y3c::vector<int> v(s.begin(), s.end());
+
+    y3c_bench::run("std::vector operator[]", 1000, [&] {
+        long total = 0;
+        for (std::size_t i = 0; i < s.size(); i++) {
+            total += s[i];
+        }
+        return total;
+    });
+    y3c_bench::run("const y3c::vector & operator[]", 100,
+                   [&] { return sum_vector(v); });
+    y3c_bench::run("iterator pair", 100,
+                   [&] { return sum_iter(v.cbegin(), v.cend()); });
+    y3c_bench::run("y3c::span operator[]", 100, [&] { return sum_span(v); });
+    y3c_bench::run("y3c::range(y3c::span)", 1000,
+                   [&] { return sum_span_range(v); });
+    return 0;
+}
@@ -0,0 +1,175 @@
+#pragma once
+#include "y3c/terminate.h"
+#include "y3c/iterator.h"
+#include <algorithm>
+
+namespace y3c {
+namespace internal {
+/*!
+ * \brief アルゴリズムに渡された範囲をチェックし、先頭のポインタを返す
+ *
+ * 範囲全体のチェックはここで1回だけ行い、
+ * その後はstd::のアルゴリズムを生ポインタに対して実行する。
+ *
+ * \param prefix エラーメッセージ用の関数名 ("y3c::sort(" など)
+ *
+ */
+template <typename element_type>
+element_type *assert_algorithm_range(
+    const contiguous_iterator<element_type> &first,
+    const contiguous_iterator<element_type> &last, const char *prefix,
+    internal::skip_trace_tag = {}) {
+    const life_observer &observer = first.get_observer_();
+    func_name func(prefix,
+                   &contiguous_iterator<element_type>::iter_type_name_of,
+                   &observer, ")");
+    if (check_bounds && observer != last.get_observer_()) {
+        y3c::internal::terminate_ub_wrong_iter(func);
+    }
+    observer.assert_range_iter(first, last, func);
+    return unwrap(first);
+}
+} // namespace internal
+
+/*!
+ * \brief 範囲をソートする (std::sort)
+ *
+ * * 範囲が無効な場合や、firstとlastが別のコンテナのイテレータの場合terminateする。
+ *
+ * \sa [sort -
+ * cpprefjp](https://cpprefjp.github.io/reference/algorithm/sort.html)
+ */
+template <typename T, typename = internal::skip_trace_tag>
+void sort(const internal::contiguous_iterator<T> &first,
+          const internal::contiguous_iterator<T> &last) {
+    T *begin = internal::assert_algorithm_range(first, last, "y3c::sort(");
+    std::sort(begin, begin + (last - first));
+}
+/*!
+ * \brief 範囲を比較関数でソートする (std::sort)
+ *
+ * * 範囲が無効な場合や、firstとlastが別のコンテナのイテレータの場合terminateする。
+ *
+ */
+template <typename T, typename Compare, typename = internal::skip_trace_tag>
+void sort(const internal::contiguous_iterator<T> &first,
+          const internal::contiguous_iterator<T> &last, Compare comp) {
+    T *begin = internal::assert_algorithm_range(first, last, "y3c::sort(");
+    std::sort(begin, begin + (last - first), comp);
+}
+
+/*!
+ * \brief 範囲をコピーする (std::copy)
+ *
+ * * コピー元の範囲が無効な場合、
+ * またはコピー先に要素数分の範囲がない場合terminateする。
+ *
+ * \return コピー先の末尾のイテレータ
+ * \sa [copy -
+ * cpprefjp](https://cpprefjp.github.io/reference/algorithm/copy.html)
+ */
+template <typename T, typename U, typename = internal::skip_trace_tag>
+internal::contiguous_iterator<U>
+copy(const internal::contiguous_iterator<T> &first,
+     const internal::contiguous_iterator<T> &last,
+     const internal::contiguous_iterator<U> &d_first) {
+    T *begin = internal::assert_algorithm_range(first, last, "y3c::copy(");
+    std::ptrdiff_t n = last - first;
+    U *d_begin = internal::assert_algorithm_range(d_first, d_first + n,
+                                                  "y3c::copy(");
+    U *d_last = std::copy(begin, begin + n, d_begin);
+    return internal::contiguous_iterator<U>(d_last, d_first.get_observer_());
+}
+/*!
+ * \brief 範囲をコンテナの末尾に追加する (std::copy + std::back_inserter)
+ *
+ * * コピー元の範囲が無効な場合terminateする。
+ * * 1要素ずつ push_back() する代わりに、まとめて追加する
+ * (再割り当てとライフタイムの更新は1回だけになる)。
+ *
+ */
+template <typename T, typename Container,
+          typename = internal::skip_trace_tag>
+back_insert_iterator<Container>
+copy(const internal::contiguous_iterator<T> &first,
+     const internal::contiguous_iterator<T> &last,
+     back_insert_iterator<Container> d_first) {
+    T *begin = internal::assert_algorithm_range(first, last, "y3c::copy(");
+    internal::func_name func(
+        "y3c::copy(", &internal::contiguous_iterator<T>::iter_type_name_of,
+        &first.get_observer_(), ")");
+    d_first.get_container_().append_(begin, begin + (last - first), func);
+    return d_first;
+}
+/*!
+ * \brief 範囲を任意の出力イテレータにコピーする (std::copy)
+ *
+ * * コピー元の範囲が無効な場合terminateする。
+ *
+ */
+template <typename T, typename OutputIt, typename = internal::skip_trace_tag>
+OutputIt copy(const internal::contiguous_iterator<T> &first,
+              const internal::contiguous_iterator<T> &last, OutputIt d_first) {
+    T *begin = internal::assert_algorithm_range(first, last, "y3c::copy(");
+    return std::copy(begin, begin + (last - first), d_first);
+}
+
+/*!
+ * \brief 値を検索する (std::find)
+ *
+ * * 範囲が無効な場合terminateする。
+ *
+ * \return 見つかった要素、または last
+ * \sa [find -
+ * cpprefjp](https://cpprefjp.github.io/reference/algorithm/find.html)
+ */
+template <typename T, typename V, typename = internal::skip_trace_tag>
+internal::contiguous_iterator<T>
+find(const internal::contiguous_iterator<T> &first,
+     const internal::contiguous_iterator<T> &last, const V &value) {
+    T *begin = internal::assert_algorithm_range(first, last, "y3c::find(");
+    return internal::contiguous_iterator<T>(
+        std::find(begin, begin + (last - first), value),
+        first.get_observer_());
+}
+
+/*!
+ * \brief ソート済みの範囲で value 以上の最初の要素を検索する
+ * (std::lower_bound)
+ *
+ * * 範囲が無効な場合terminateする。
+ *
+ * \sa [lower_bound -
+ * cpprefjp](https://cpprefjp.github.io/reference/algorithm/lower_bound.html)
+ */
+template <typename T, typename V, typename = internal::skip_trace_tag>
+internal::contiguous_iterator<T>
+lower_bound(const internal::contiguous_iterator<T> &first,
+            const internal::contiguous_iterator<T> &last, const V &value) {
+    T *begin =
+        internal::assert_algorithm_range(first, last, "y3c::lower_bound(");
+    return internal::contiguous_iterator<T>(
+        std::lower_bound(begin, begin + (last - first), value),
+        first.get_observer_());
+}
+/*!
+ * \brief ソート済みの範囲で value 以上の最初の要素を比較関数を使って検索する
+ * (std::lower_bound)
+ *
+ * * 範囲が無効な場合terminateする。
+ *
+ */
+template <typename T, typename V, typename Compare,
+          typename = internal::skip_trace_tag>
+internal::contiguous_iterator<T>
+lower_bound(const internal::contiguous_iterator<T> &first,
+            const internal::contiguous_iterator<T> &last, const V &value,
+            Compare comp) {
+    T *begin =
+        internal::assert_algorithm_range(first, last, "y3c::lower_bound(");
+    return internal::contiguous_iterator<T>(
+        std::lower_bound(begin, begin + (last - first), value, comp),
+        first.get_observer_());
+}
+
+} // namespace y3c
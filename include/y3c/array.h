@@ -22,10 +22,10 @@ class array {
     internal::life elems_life_;
     internal::life life_;
 
-    const std::string &type_name() const {
+    static const std::string &type_name() {
         return internal::get_type_name<array>();
     }
-    const std::string &iter_name() const {
+    static const std::string &iter_name() {
         static std::string name =
             internal::get_type_name<array>() + "::iterator";
         return name;
@@ -37,14 +37,15 @@ class array {
      */
     array()
         : base_(), elems_life_(N == 0 ? nullptr : &base_[0],
-                               N == 0 ? nullptr : &base_[0] + N),
+                               N == 0 ? nullptr : &base_[0] + N, &iter_name),
           life_(this) {}
     /*!
      * \brief コピーコンストラクタ
      */
     array(const array &other)
         : base_(other.base_), elems_life_(N == 0 ? nullptr : &base_[0],
-                                          N == 0 ? nullptr : &base_[0] + N),
+                                          N == 0 ? nullptr : &base_[0] + N,
+                                          &iter_name),
           life_(this) {}
     /*!
      * \brief コピー代入
@@ -59,7 +60,7 @@ class array {
     array(array &&other)
         : base_(std::move(other.base_)),
           elems_life_(N == 0 ? nullptr : &base_[0],
-                      N == 0 ? nullptr : &base_[0] + N),
+                      N == 0 ? nullptr : &base_[0] + N, &iter_name),
           life_(this) {}
     /*!
      * \brief ムーブ代入
@@ -87,7 +88,8 @@ class array {
      */
     array(const std::array<T, N> &elems)
         : base_(elems), elems_life_(N == 0 ? nullptr : &base_[0],
-                                    N == 0 ? nullptr : &base_[0] + N),
+                                    N == 0 ? nullptr : &base_[0] + N,
+                                    &iter_name),
           life_(this) {}
     /*!
      * \brief std::arrayからのムーブ
@@ -95,7 +97,7 @@ class array {
     array(std::array<T, N> &&elems)
         : base_(std::move(elems)),
           elems_life_(N == 0 ? nullptr : &base_[0],
-                      N == 0 ? nullptr : &base_[0] + N),
+                      N == 0 ? nullptr : &base_[0] + N, &iter_name),
           life_(this) {}
     /*!
      * \brief std::arrayからのコピー
@@ -116,8 +118,9 @@ class array {
     using const_reference = const_wrap_ref<T>;
     using iterator = internal::contiguous_iterator<T>;
     using const_iterator = internal::contiguous_iterator<const T>;
-    // using reverse_iterator = std::reverse_iterator<iterator>;
-    // using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    using reverse_iterator = internal::contiguous_reverse_iterator<T>;
+    using const_reverse_iterator =
+        internal::contiguous_reverse_iterator<const T>;
     using size_type = std::size_t;
     using difference_type = std::ptrdiff_t;
     using pointer = ptr<T>;
@@ -132,8 +135,9 @@ class array {
      */
     reference at(size_type n, internal::skip_trace_tag = {}) {
         if (n >= N) {
-            static std::string func = type_name() + "::at()";
-            throw y3c::out_of_range(func, N, static_cast<std::ptrdiff_t>(n));
+            static constexpr internal::func_name func{&type_name, "::at()"};
+            internal::throw_out_of_range(func, N,
+                                         static_cast<std::ptrdiff_t>(n));
         }
         return reference(&this->base_[n], this->elems_life_.observer());
     }
@@ -145,8 +149,9 @@ class array {
      */
     const_reference at(size_type n, internal::skip_trace_tag = {}) const {
         if (n >= N) {
-            static std::string func = type_name() + "::at()";
-            throw y3c::out_of_range(func, N, static_cast<std::ptrdiff_t>(n));
+            static constexpr internal::func_name func{&type_name, "::at()"};
+            internal::throw_out_of_range(func, N,
+                                         static_cast<std::ptrdiff_t>(n));
         }
         return const_reference(&this->base_[n], this->elems_life_.observer());
     }
@@ -158,8 +163,9 @@ class array {
      */
     template <typename = internal::skip_trace_tag>
     reference operator[](size_type n) {
-        if (n >= N) {
-            static std::string func = type_name() + "::operator[]()";
+        if (internal::check_bounds && n >= N) {
+            static constexpr internal::func_name func{&type_name,
+                                                      "::operator[]()"};
             y3c::internal::terminate_ub_out_of_range(
                 func, N, static_cast<std::ptrdiff_t>(n));
         }
@@ -173,8 +179,9 @@ class array {
      */
     template <typename = internal::skip_trace_tag>
     const_reference operator[](size_type n) const {
-        if (n >= N) {
-            static std::string func = type_name() + "::operator[]()";
+        if (internal::check_bounds && n >= N) {
+            static constexpr internal::func_name func{&type_name,
+                                                      "::operator[]()"};
             y3c::internal::terminate_ub_out_of_range(
                 func, N, static_cast<std::ptrdiff_t>(n));
         }
@@ -188,8 +195,8 @@ class array {
      *
      */
     reference front(internal::skip_trace_tag = {}) {
-        if (N == 0) {
-            static std::string func = type_name() + "::front()";
+        if (internal::check_bounds && N == 0) {
+            static constexpr internal::func_name func{&type_name, "::front()"};
             y3c::internal::terminate_ub_out_of_range(func, N, 0);
         }
         return reference(&this->base_.front(), this->elems_life_.observer());
@@ -201,8 +208,8 @@ class array {
      *
      */
     const_reference front(internal::skip_trace_tag = {}) const {
-        if (N == 0) {
-            static std::string func = type_name() + "::front()";
+        if (internal::check_bounds && N == 0) {
+            static constexpr internal::func_name func{&type_name, "::front()"};
             y3c::internal::terminate_ub_out_of_range(func, N, 0);
         }
         return const_reference(&this->base_.front(),
@@ -215,8 +222,8 @@ class array {
      *
      */
     reference back(internal::skip_trace_tag = {}) {
-        if (N == 0) {
-            static std::string func = type_name() + "::back()";
+        if (internal::check_bounds && N == 0) {
+            static constexpr internal::func_name func{&type_name, "::back()"};
             y3c::internal::terminate_ub_out_of_range(func, N, -1);
         }
         return reference(&this->base_.back(), this->elems_life_.observer());
@@ -228,8 +235,8 @@ class array {
      *
      */
     const_reference back(internal::skip_trace_tag = {}) const {
-        if (N == 0) {
-            static std::string func = type_name() + "::back()";
+        if (internal::check_bounds && N == 0) {
+            static constexpr internal::func_name func{&type_name, "::back()"};
             y3c::internal::terminate_ub_out_of_range(func, N, -1);
         }
         return const_reference(&this->base_.back(),
@@ -269,11 +276,9 @@ class array {
      */
     iterator begin() {
         if (N == 0) {
-            return iterator(nullptr, this->elems_life_.observer(),
-                            &iter_name());
+            return iterator(nullptr, this->elems_life_.observer());
         }
-        return iterator(&this->base_.front(), this->elems_life_.observer(),
-                        &iter_name());
+        return iterator(&this->base_.front(), this->elems_life_.observer());
     }
     /*!
      * \brief 先頭要素を指すconstイテレータを取得
@@ -283,11 +288,10 @@ class array {
      */
     const_iterator begin() const {
         if (N == 0) {
-            return const_iterator(nullptr, this->elems_life_.observer(),
-                                  &iter_name());
+            return const_iterator(nullptr, this->elems_life_.observer());
         }
         return const_iterator(&this->base_.front(),
-                              this->elems_life_.observer(), &iter_name());
+                              this->elems_life_.observer());
     }
     /*!
      * \brief 先頭要素を指すconstイテレータを取得
@@ -317,6 +321,63 @@ class array {
      *
      */
     const_iterator cend() const { return begin() + N; }
+    /*!
+     * \brief 末尾要素を指す逆イテレータを取得
+     *
+     * * end() を base() とする逆イテレータ。
+     * * サイズが0の場合無効なイテレータを返す。
+     *
+     */
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    /*!
+     * \brief 末尾要素を指すconst逆イテレータを取得
+     */
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(end());
+    }
+    /*!
+     * \brief 末尾要素を指すconst逆イテレータを取得
+     */
+    const_reverse_iterator crbegin() const { return rbegin(); }
+    /*!
+     * \brief 先頭要素の前を指す逆イテレータを取得
+     *
+     * * begin() を base() とする逆イテレータ。
+     * * サイズが0の場合無効なイテレータを返す。
+     *
+     */
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    /*!
+     * \brief 先頭要素の前を指すconst逆イテレータを取得
+     */
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(begin());
+    }
+    /*!
+     * \brief 先頭要素の前を指すconst逆イテレータを取得
+     */
+    const_reverse_iterator crend() const { return rend(); }
+
+    /*!
+     * \brief y3c::range() の実装
+     */
+    internal::contiguous_range<T> get_range_() {
+        static constexpr internal::func_name func{"y3c::range(", &type_name,
+                                                  ")"};
+        T *begin = N == 0 ? nullptr : &this->base_[0];
+        return internal::contiguous_range<T>(
+            begin, begin + N, this->elems_life_.observer(), func);
+    }
+    /*!
+     * \brief y3c::range() の実装(const)
+     */
+    internal::contiguous_range<const T> get_range_() const {
+        static constexpr internal::func_name func{"y3c::range(", &type_name,
+                                                  ")"};
+        const T *begin = N == 0 ? nullptr : &this->base_[0];
+        return internal::contiguous_range<const T>(
+            begin, begin + N, this->elems_life_.observer(), func);
+    }
 
     /*!
      * \brief sizeが0かどうかを返す
@@ -377,6 +438,26 @@ const std::array<T, N> &unwrap(const array<T, N> &wrapper) noexcept {
     return static_cast<const std::array<T, N> &>(wrapper);
 }
 
+/*!
+ * \brief 範囲のチェックをループの開始時に1回だけ行う range-for 用の範囲
+ *
+ * `for (auto &x : y3c::range(a))` のように使う。
+ *
+ * * 要素は wrap<T&> ではなく T& で得られる。
+ * * ループ中にarrayが破棄された場合terminateする。
+ *
+ */
+template <typename T, std::size_t N>
+internal::contiguous_range<T> range(array<T, N> &a) {
+    return a.get_range_();
+}
+template <typename T, std::size_t N>
+internal::contiguous_range<const T> range(const array<T, N> &a) {
+    return a.get_range_();
+}
+template <typename T, std::size_t N>
+void range(const array<T, N> &&) = delete;
+
 template <typename T, std::size_t N>
 void swap(array<T, N> &lhs, array<T, N> &rhs) {
     lhs.swap(rhs);
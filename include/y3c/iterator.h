@@ -2,12 +2,16 @@
 #include "y3c/terminate.h"
 #include "y3c/life.h"
 #include "y3c/wrap.h"
+#include "y3c/typename.h"
+#include <iterator>
 #include <memory>
 
 namespace y3c {
 namespace internal {
 template <typename element_type>
 class contiguous_iterator;
+template <typename element_type>
+class contiguous_reverse_iterator;
 
 template <typename element_type>
 element_type *unwrap(const contiguous_iterator<element_type> &wrapper) noexcept;
@@ -21,61 +25,97 @@ element_type *unwrap(const contiguous_iterator<element_type> &wrapper) noexcept;
  * * また `operator*`, `operator[]` が返す参照はラップ済み (y3c::wrap<T&>)
  * * `operator&` は未実装 (要るのか?)
  *
+ * 値で渡されることが多いので小さく保つ
+ * (ポインタ、observer、validator、自身のライフタイムの4ワード)。
+ * 型名はコンテナ側のlifeに持たせて observer から取得する。
+ *
  */
 template <typename element_type>
 class contiguous_iterator {
     element_type *ptr_;
     internal::life_observer observer_;
-    std::shared_ptr<internal::life_validator> validator_;
-    internal::life life_;
+    internal::life_validator validator_;
+    internal::object_life life_;
 
-    const std::string *type_name_;
-    const std::string &type_name() const {
-        // return internal::get_type_name<contiguous_iterator>();
-        return *type_name_;
+    /*!
+     * \brief エラーメッセージ用の関数名
+     *
+     * 型名はコンテナ側のlifeに持たせてあるものを使う。
+     * 取得するのはterminateするときだけで、ここでは observer_ に触れない
+     * (チェックが無効なレベルや、型名の無いobserverでも安全)。
+     *
+     */
+    internal::func_name func(const char *suffix) const {
+        return internal::func_name("", &iter_type_name_of, &observer_, suffix);
     }
 
-    element_type *assert_iter(const std::string &func,
+    element_type *assert_iter(const internal::func_name &func,
                               internal::skip_trace_tag = {}) const {
         return observer_.assert_iter(*this, func);
     }
     element_type *
-    assert_iter_including_end(const std::string &func,
+    assert_iter_including_end(const internal::func_name &func,
                               internal::skip_trace_tag = {}) const {
         return observer_.assert_iter_including_end(*this, func);
     }
-    void update_iter(const std::string &func,
-                     internal::skip_trace_tag = {}) const {
-        validator_->ptr_ = this->ptr_;
-        if (!validator_->valid_) {
+    /*!
+     * \brief このイテレータが無効化されていないか
+     *
+     * 寿命のチェックが無効な場合は常にtrue
+     *
+     */
+    bool is_valid_() const {
+        return !internal::check_lifetime ||
+               observer_.is_valid(validator_, ptr_);
+    }
+    /*!
+     * \brief ptr_ をn進めて、移動後のイテレータをチェックする
+     *
+     * \param reversed 逆イテレータから呼ぶ場合true
+     * (範囲外に出た場合のエラーの前後を入れ替える)
+     */
+    void update_iter(std::ptrdiff_t n, const internal::func_name &func,
+                     bool reversed = false, internal::skip_trace_tag = {}) {
+        // validatorの更新はサンプリングで省略しない
+        // (省略すると移動後の位置で古い無効化を判定してしまい、誤検出になる)
+        if (internal::check_lifetime) {
+            observer_.update_validator(validator_, this->ptr_);
+        }
+        this->ptr_ += n;
+        if (internal::check_lifetime && !validator_.valid()) {
             // assert_iterではdeletedの場合deletedメッセージが優先されるが、
             // ここではdeletedの場合にもinvalid iterのメッセージで止まる。
-            // あとコンストラクタで新しいvalidatorを作った後ここに来るというルートは若干無駄があるという問題もある
             y3c::internal::terminate_ub_invalid_iter(func);
         }
-        if (ptr_ > observer_.end()) {
+        if (internal::check_bounds && ptr_ > observer_.end()) {
+            if (reversed) {
+                internal::terminate_ub_iter_before_begin(func);
+            }
             internal::terminate_ub_iter_after_end(func);
         }
-        if (ptr_ < observer_.begin()) {
+        if (internal::check_bounds && ptr_ < observer_.begin()) {
+            if (reversed) {
+                internal::terminate_ub_iter_after_end(func);
+            }
             internal::terminate_ub_iter_before_begin(func);
         }
     }
 
   public:
+    /*!
+     * \param observer 指す範囲のobserver
+     * (lifeの作成時にイテレータの型名を渡しておくこと)
+     */
+    contiguous_iterator(element_type *ptr,
+                        internal::life_observer observer) noexcept
+        : ptr_(ptr), observer_(std::move(observer)),
+          validator_(observer_.make_validator(/* always valid */)), life_() {}
     contiguous_iterator(element_type *ptr, internal::life_observer observer,
-                        const std::string *type_name) noexcept
-        : ptr_(ptr), observer_(observer),
-          validator_(observer.push_validator(
-              std::make_shared<life_validator>(ptr /* always valid */))),
-          life_(this), type_name_(type_name) {}
-    contiguous_iterator(element_type *ptr, internal::life_observer observer,
-                        const std::string *type_name, bool valid,
-                        const std::string &func, internal::skip_trace_tag = {})
-        : ptr_(ptr), observer_(observer),
-          validator_(observer.push_validator(
-              std::make_shared<life_validator>(ptr, valid))),
-          life_(this), type_name_(type_name) {
-        update_iter(func);
+                        bool valid, const internal::func_name &func,
+                        internal::skip_trace_tag = {})
+        : ptr_(ptr), observer_(std::move(observer)),
+          validator_(observer_.make_validator(valid)), life_() {
+        update_iter(0, func);
     }
 
     template <typename T, typename std::enable_if<
@@ -83,29 +123,34 @@ class contiguous_iterator {
                               std::nullptr_t>::type = nullptr>
     contiguous_iterator(const contiguous_iterator<T> &other)
         : ptr_(other.ptr_), observer_(other.observer_),
-          validator_(observer_.push_validator(
-              std::make_shared<life_validator>(*other.validator_))),
-          life_(this), type_name_(other.type_name_) {}
+          validator_(other.validator_), life_() {}
 
     contiguous_iterator(const contiguous_iterator &other)
         : ptr_(other.ptr_), observer_(other.observer_),
-          validator_(observer_.push_validator(
-              std::make_shared<life_validator>(*other.validator_))),
-          life_(this), type_name_(other.type_name_) {}
+          validator_(other.validator_), life_() {}
     contiguous_iterator &operator=(const contiguous_iterator &other) {
         ptr_ = other.ptr_;
+        // 古いvalidatorは古いobserverのstateを参照しているので先に置き換える
+        validator_ = other.validator_;
         observer_ = other.observer_;
-        validator_ = observer_.push_validator(
-            std::make_shared<life_validator>(*other.validator_));
-        type_name_ = other.type_name_;
         return *this;
     }
     ~contiguous_iterator() = default;
 
     template <typename T>
     friend class contiguous_iterator;
+    template <typename T>
+    friend class contiguous_reverse_iterator;
     friend class life_observer;
     const life_observer &get_observer_() const { return this->observer_; }
+    const life_validator &get_validator_() const { return this->validator_; }
+    /*!
+     * \brief func_name の type_name_of に渡す、observerからイテレータの型名を得る関数
+     */
+    static const std::string &iter_type_name_of(const void *observer) {
+        return internal::life_observer::iter_type_name_of<
+            &internal::get_type_name<contiguous_iterator>>(observer);
+    }
     friend element_type *y3c::internal::unwrap<>(
         const contiguous_iterator<element_type> &wrapper) noexcept;
 
@@ -117,64 +162,54 @@ class contiguous_iterator {
 
     template <typename = internal::skip_trace_tag>
     reference operator*() const {
-        std::string func = type_name() + "::operator*()";
-        return reference(assert_iter(func), observer_);
+        return reference(assert_iter(func("::operator*()")), observer_);
     }
     template <typename = internal::skip_trace_tag>
     element_type *operator->() const {
-        std::string func = type_name() + "::operator->()";
-        return assert_iter(func);
+        return assert_iter(func("::operator->()"));
     }
 
     template <typename = internal::skip_trace_tag>
     contiguous_iterator &operator++() {
-        ++this->ptr_;
-        update_iter(type_name() + "::operator++()");
+        update_iter(1, func("::operator++()"));
         return *this;
     }
     template <typename = internal::skip_trace_tag>
     contiguous_iterator operator++(int) {
         contiguous_iterator copy = *this;
-        ++this->ptr_;
-        update_iter(type_name() + "::operator++()");
+        update_iter(1, func("::operator++()"));
         return copy;
     }
     template <typename = internal::skip_trace_tag>
     contiguous_iterator &operator--() {
-        --this->ptr_;
-        update_iter(type_name() + "::operator--()");
+        update_iter(-1, func("::operator--()"));
         return *this;
     }
     template <typename = internal::skip_trace_tag>
     contiguous_iterator operator--(int) {
         contiguous_iterator copy = *this;
-        --this->ptr_;
-        update_iter(type_name() + "::operator--()");
+        update_iter(-1, func("::operator--()"));
         return copy;
     }
     template <typename = internal::skip_trace_tag>
     contiguous_iterator &operator+=(std::ptrdiff_t n) {
-        this->ptr_ += n;
-        update_iter(type_name() + "::operator+=()");
+        update_iter(n, func("::operator+=()"));
         return *this;
     }
     template <typename = internal::skip_trace_tag>
     contiguous_iterator &operator-=(std::ptrdiff_t n) {
-        this->ptr_ -= n;
-        update_iter(type_name() + "::operator-=()");
+        update_iter(-n, func("::operator-=()"));
         return *this;
     }
     template <typename = internal::skip_trace_tag>
     contiguous_iterator operator+(std::ptrdiff_t n) const {
-        return contiguous_iterator(this->ptr_ + n, this->observer_, type_name_,
-                                   this->validator_->valid_,
-                                   type_name() + "::operator+()");
+        return contiguous_iterator(this->ptr_ + n, this->observer_,
+                                   is_valid_(), func("::operator+()"));
     }
     template <typename = internal::skip_trace_tag>
     contiguous_iterator operator-(std::ptrdiff_t n) const {
-        return contiguous_iterator(this->ptr_ - n, this->observer_, type_name_,
-                                   this->validator_->valid_,
-                                   type_name() + "::operator-()");
+        return contiguous_iterator(this->ptr_ - n, this->observer_,
+                                   is_valid_(), func("::operator-()"));
     }
 
     std::ptrdiff_t operator-(const contiguous_iterator &other) const noexcept {
@@ -182,25 +217,25 @@ class contiguous_iterator {
     }
     template <typename = internal::skip_trace_tag>
     reference operator[](std::ptrdiff_t n) const {
-        static std::string func = type_name() + "::operator[]()";
-        return reference(contiguous_iterator(this->ptr_ + n, this->observer_,
-                                             type_name_,
-                                             this->validator_->valid_, func)
-                             .assert_iter(func),
-                         observer_);
+        internal::func_name name = func("::operator[]()");
+        return reference(
+            contiguous_iterator(this->ptr_ + n, this->observer_, is_valid_(),
+                                name)
+                .assert_iter(name),
+            observer_);
     }
 
     operator wrap<contiguous_iterator &>() noexcept {
-        return wrap<contiguous_iterator &>(this, life_.observer());
+        return wrap<contiguous_iterator &>(this, life_.observer(this));
     }
     operator wrap<const contiguous_iterator &>() const noexcept {
-        return wrap<const contiguous_iterator &>(this, life_.observer());
+        return wrap<const contiguous_iterator &>(this, life_.observer(this));
     }
     wrap<contiguous_iterator *> operator&() {
-        return wrap<contiguous_iterator *>(this, life_.observer());
+        return wrap<contiguous_iterator *>(this, life_.observer(this));
     }
     wrap<const contiguous_iterator *> operator&() const {
-        return wrap<const contiguous_iterator *>(this, life_.observer());
+        return wrap<const contiguous_iterator *>(this, life_.observer(this));
     }
 };
 
@@ -241,6 +276,239 @@ bool operator>=(const contiguous_iterator<T> &lhs,
                 const contiguous_iterator<T> &rhs) {
     return unwrap(lhs) >= unwrap(rhs);
 }
+/*!
+ * \brief array, vector など各種コンテナの逆イテレータ (std::reverse_iterator)
+ *
+ * * std::reverse_iterator と同様、1つ後ろを指す順方向のイテレータ (base())
+ * を1つだけ持ち、その validator をそのまま使う。
+ * 移動や比較のたびに一時的なイテレータを作らないので、
+ * 順方向のイテレータと同じコストで走査できる。
+ * * `operator*` などは base() の1つ前の要素をチェックする。
+ * * 範囲外への移動は逆順の向きで iter_after_end / iter_before_begin になる。
+ *
+ * \sa [reverse_iterator -
+ * cpprefjp](https://cpprefjp.github.io/reference/iterator/reverse_iterator.html)
+ */
+template <typename element_type>
+class contiguous_reverse_iterator {
+    contiguous_iterator<element_type> current_;
+
+    internal::func_name func(const char *suffix) const {
+        return internal::func_name("reverse_iterator<",
+                                   &contiguous_iterator<
+                                       element_type>::iter_type_name_of,
+                                   &current_.observer_, suffix);
+    }
+
+    element_type *assert_iter(const internal::func_name &func,
+                              internal::skip_trace_tag = {}) const {
+        return current_.observer_.assert_reverse_iter(current_, func);
+    }
+
+  public:
+    /*!
+     * \param current 逆イテレータの指す要素の1つ後ろを指すイテレータ
+     */
+    explicit contiguous_reverse_iterator(
+        contiguous_iterator<element_type> current) noexcept
+        : current_(std::move(current)) {}
+
+    template <typename T, typename std::enable_if<
+                              std::is_same<const T, element_type>::value,
+                              std::nullptr_t>::type = nullptr>
+    contiguous_reverse_iterator(const contiguous_reverse_iterator<T> &other)
+        : current_(other.base()) {}
+
+    template <typename T>
+    friend class contiguous_reverse_iterator;
+
+    using iterator_type = contiguous_iterator<element_type>;
+    using difference_type = std::ptrdiff_t;
+    using value_type = element_type;
+    using pointer = element_type *;
+    using reference = wrap_ref<element_type>;
+    using iterator_category = std::random_access_iterator_tag;
+
+    /*!
+     * \brief 1つ後ろを指す順方向のイテレータ
+     */
+    const contiguous_iterator<element_type> &base() const noexcept {
+        return current_;
+    }
+
+    template <typename = internal::skip_trace_tag>
+    reference operator*() const {
+        return reference(assert_iter(func(">::operator*()")),
+                         current_.observer_);
+    }
+    template <typename = internal::skip_trace_tag>
+    element_type *operator->() const {
+        return assert_iter(func(">::operator->()"));
+    }
+
+    template <typename = internal::skip_trace_tag>
+    contiguous_reverse_iterator &operator++() {
+        current_.update_iter(-1, func(">::operator++()"), true);
+        return *this;
+    }
+    template <typename = internal::skip_trace_tag>
+    contiguous_reverse_iterator operator++(int) {
+        contiguous_reverse_iterator copy = *this;
+        current_.update_iter(-1, func(">::operator++()"), true);
+        return copy;
+    }
+    template <typename = internal::skip_trace_tag>
+    contiguous_reverse_iterator &operator--() {
+        current_.update_iter(1, func(">::operator--()"), true);
+        return *this;
+    }
+    template <typename = internal::skip_trace_tag>
+    contiguous_reverse_iterator operator--(int) {
+        contiguous_reverse_iterator copy = *this;
+        current_.update_iter(1, func(">::operator--()"), true);
+        return copy;
+    }
+    template <typename = internal::skip_trace_tag>
+    contiguous_reverse_iterator &operator+=(std::ptrdiff_t n) {
+        current_.update_iter(-n, func(">::operator+=()"), true);
+        return *this;
+    }
+    template <typename = internal::skip_trace_tag>
+    contiguous_reverse_iterator &operator-=(std::ptrdiff_t n) {
+        current_.update_iter(n, func(">::operator-=()"), true);
+        return *this;
+    }
+    template <typename = internal::skip_trace_tag>
+    contiguous_reverse_iterator operator+(std::ptrdiff_t n) const {
+        contiguous_reverse_iterator copy = *this;
+        copy.current_.update_iter(-n, func(">::operator+()"), true);
+        return copy;
+    }
+    template <typename = internal::skip_trace_tag>
+    contiguous_reverse_iterator operator-(std::ptrdiff_t n) const {
+        contiguous_reverse_iterator copy = *this;
+        copy.current_.update_iter(n, func(">::operator-()"), true);
+        return copy;
+    }
+
+    std::ptrdiff_t
+    operator-(const contiguous_reverse_iterator &other) const noexcept {
+        return other.current_.ptr_ - current_.ptr_;
+    }
+    template <typename = internal::skip_trace_tag>
+    reference operator[](std::ptrdiff_t n) const {
+        internal::func_name name = func(">::operator[]()");
+        contiguous_reverse_iterator copy = *this;
+        copy.current_.update_iter(-n, name, true);
+        return reference(copy.assert_iter(name), current_.observer_);
+    }
+};
+
+template <typename T>
+bool operator==(const contiguous_reverse_iterator<T> &lhs,
+                const contiguous_reverse_iterator<T> &rhs) {
+    return lhs.base() == rhs.base();
+}
+template <typename T>
+bool operator!=(const contiguous_reverse_iterator<T> &lhs,
+                const contiguous_reverse_iterator<T> &rhs) {
+    return lhs.base() != rhs.base();
+}
+template <typename T>
+bool operator<(const contiguous_reverse_iterator<T> &lhs,
+               const contiguous_reverse_iterator<T> &rhs) {
+    return lhs.base() > rhs.base();
+}
+template <typename T>
+bool operator>(const contiguous_reverse_iterator<T> &lhs,
+               const contiguous_reverse_iterator<T> &rhs) {
+    return lhs.base() < rhs.base();
+}
+template <typename T>
+bool operator<=(const contiguous_reverse_iterator<T> &lhs,
+                const contiguous_reverse_iterator<T> &rhs) {
+    return lhs.base() >= rhs.base();
+}
+template <typename T>
+bool operator>=(const contiguous_reverse_iterator<T> &lhs,
+                const contiguous_reverse_iterator<T> &rhs) {
+    return lhs.base() <= rhs.base();
+}
+
+/*!
+ * \brief y3c::range() が返す、range-for 用の範囲
+ *
+ * 作成時に1回だけobserverとvalidatorを取得し、
+ * ループ中は生ポインタで要素を走査する。
+ * 要素の参照も wrap<T&> ではなく T& を返す。
+ *
+ * 毎回のループ条件の判定時に、コンテナが変更されて
+ * 現在位置が無効になっていないかだけをチェックする
+ * (変更がなければ世代の比較だけで済む)。
+ *
+ * range-for で使うことだけを想定していて、
+ * イテレータはこの範囲のオブジェクトより長く使ってはいけない。
+ *
+ */
+template <typename element_type>
+class contiguous_range {
+    element_type *begin_, *end_;
+    life_observer observer_;
+    life_validator validator_;
+    func_name func_;
+
+    void check_(const element_type *ptr) const {
+        if (check_lifetime && !observer_.is_valid(validator_, ptr)) {
+            y3c::internal::terminate_ub_invalid_iter(func_);
+        }
+    }
+
+  public:
+    contiguous_range(element_type *begin, element_type *end,
+                     life_observer observer, const func_name &func)
+        : begin_(begin), end_(end), observer_(std::move(observer)),
+          validator_(observer_.make_validator()), func_(func) {}
+    contiguous_range(const contiguous_range &) = default;
+    contiguous_range &operator=(const contiguous_range &) = delete;
+
+    class iterator {
+        element_type *ptr_;
+        const contiguous_range *range_;
+
+      public:
+        iterator(element_type *ptr, const contiguous_range *range) noexcept
+            : ptr_(ptr), range_(range) {}
+
+        element_type &operator*() const noexcept { return *ptr_; }
+        element_type *operator->() const noexcept { return ptr_; }
+        iterator &operator++() noexcept {
+            ++ptr_;
+            return *this;
+        }
+        /*!
+         * 終端に達していなければ、現在位置が無効になっていないかチェックする
+         */
+        template <typename = internal::skip_trace_tag>
+        bool operator!=(const iterator &other) const {
+            if (ptr_ == other.ptr_) {
+                return false;
+            }
+            range_->check_(ptr_);
+            return true;
+        }
+        template <typename = internal::skip_trace_tag>
+        bool operator==(const iterator &other) const {
+            return !(*this != other);
+        }
+    };
+
+    iterator begin() const noexcept { return iterator(begin_, this); }
+    iterator end() const noexcept { return iterator(end_, this); }
+    std::size_t size() const noexcept {
+        return static_cast<std::size_t>(end_ - begin_);
+    }
+};
+
 } // namespace internal
 
 template <typename element_type>
@@ -249,4 +517,52 @@ unwrap(const internal::contiguous_iterator<element_type> &wrapper) noexcept {
     return internal::unwrap(wrapper);
 }
 
+/*!
+ * \brief 末尾に要素を追加する出力イテレータ (std::back_insert_iterator)
+ *
+ * * 代入するたびに push_back() を呼ぶ。
+ * * y3c::copy() の出力先として渡した場合は、
+ * コンテナの append_() でまとめて追加する。
+ *
+ * \sa [back_insert_iterator -
+ * cpprefjp](https://cpprefjp.github.io/reference/iterator/back_insert_iterator.html)
+ */
+template <typename Container>
+class back_insert_iterator {
+    Container *container_;
+
+  public:
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = void;
+    using container_type = Container;
+
+    explicit back_insert_iterator(Container &c) noexcept
+        : container_(std::addressof(c)) {}
+
+    Container &get_container_() const noexcept { return *container_; }
+
+    back_insert_iterator &
+    operator=(const typename Container::value_type &value) {
+        container_->push_back(value);
+        return *this;
+    }
+    back_insert_iterator &operator=(typename Container::value_type &&value) {
+        container_->push_back(std::move(value));
+        return *this;
+    }
+    back_insert_iterator &operator*() noexcept { return *this; }
+    back_insert_iterator &operator++() noexcept { return *this; }
+    back_insert_iterator operator++(int) noexcept { return *this; }
+};
+/*!
+ * \brief y3c::back_insert_iterator を作る (std::back_inserter)
+ */
+template <typename Container>
+back_insert_iterator<Container> back_inserter(Container &c) noexcept {
+    return back_insert_iterator<Container>(c);
+}
+
 } // namespace y3c
@@ -1,81 +1,795 @@
 #pragma once
 #include "y3c/terminate.h"
-#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
 #include <vector>
+#if !Y3C_SINGLE_THREADED
+#include <mutex>
+#endif
 
 namespace y3c {
 namespace internal {
 template <typename element_type>
 class contiguous_iterator;
+class life_state;
 
-struct life_validator {
-    const void *ptr_;
-    bool valid_;
+/*!
+ * \brief life_state::update_range() で無効化された範囲の境界
+ *
+ * この更新より前の世代で ptr を指していたイテレータは、
+ * 上限の記録では ptr < bound 、下限の記録では bound <= ptr
+ * を満たさなければ無効になる
+ *
+ */
+struct life_invalidation {
+    std::size_t generation;
+    const void *bound;
+};
+/*!
+ * \brief life_invalidation を世代順かつアドレス順に保持するリスト
+ *
+ * 新しい記録より緩い記録(それより後の世代から見て判定に影響しないもの)
+ * は追加時に削除するので、
+ * 残った記録は世代について昇順、boundについても単調になる。
+ * したがってある世代以降の記録のうち最も厳しいものは二分探索で1つに決まる。
+ *
+ * 最後の記録と同じ世代の記録は1つにまとめる
+ * (同じ世代の記録は同じvalidatorに対して判定に使われるので、厳しい方だけ残す)。
+ *
+ * \tparam upper trueなら上限(小さいほど厳しい)、falseなら下限(大きいほど厳しい)
+ *
+ */
+template <bool upper>
+class life_invalidation_list {
+    std::vector<life_invalidation> list_;
+
+    static bool stricter_or_equal(const void *a, const void *b) {
+        return upper ? !(b < a) : !(a < b);
+    }
+
+    /*!
+     * \brief 世代generationより後の最初の記録
+     */
+    typename std::vector<life_invalidation>::const_iterator
+    find(std::size_t generation) const {
+        return std::upper_bound(
+            list_.begin(), list_.end(), generation,
+            [](std::size_t g, const life_invalidation &inv) {
+                return g < inv.generation;
+            });
+    }
+
+  public:
+    /*!
+     * \brief 記録を追加する
+     *
+     * 削除する記録の数をkとして O(k)
+     *
+     */
+    void push(std::size_t generation, const void *bound) {
+        while (!list_.empty() && stricter_or_equal(bound, list_.back().bound)) {
+            list_.pop_back();
+        }
+        if (!list_.empty() && list_.back().generation == generation) {
+            return;
+        }
+        list_.push_back({generation, bound});
+    }
+    /*!
+     * \brief 世代generationより後の記録で、ptrが無効化されているかどうか
+     *
+     * O(log n)
+     *
+     */
+    bool invalidates(const void *ptr, std::size_t generation) const {
+        auto it = find(generation);
+        if (it == list_.end()) {
+            return false;
+        }
+        return upper ? !(ptr < it->bound) : ptr < it->bound;
+    }
+    /*!
+     * \brief 世代が (after, upto] の記録を、keep_first なら最初の1つだけ残して削除する
+     *
+     * 世代afterより後の記録のうち判定に使われるのは最初のものだけなので、
+     * その間の世代のvalidatorがなくなれば残りは不要になる。
+     * keep_first がfalseの場合はafterを無視して upto 以前の記録を全て削除する。
+     *
+     */
+    void prune(bool keep_first, std::size_t after, std::size_t upto) {
+        auto first = list_.cbegin();
+        if (keep_first) {
+            first = find(after);
+            if (first != list_.end() && first->generation <= upto) {
+                ++first;
+            }
+        }
+        auto last = find(upto);
+        if (first < last) {
+            list_.erase(first, last);
+        }
+    }
+    /*!
+     * \brief 最後の記録のbound (記録が無い場合nullptr)
+     */
+    const void *back_bound() const {
+        return list_.empty() ? nullptr : list_.back().bound;
+    }
+    void clear() { list_.clear(); }
+    std::size_t size() const { return list_.size(); }
+};
+/*!
+ * \brief 固定サイズのメモリブロックを使い回すスレッドごとのプール
+ *
+ * 解放されたブロックを max_free 個までフリーリストに保持し、
+ * 次の確保時に再利用する。
+ * スレッド終了時(またはそれ以降)に解放されたブロックはそのまま delete する。
+ *
+ */
+template <std::size_t block_size>
+class fixed_size_pool {
+    struct block {
+        block *next;
+    };
+    struct free_list {
+        block *head;
+        std::size_t count;
+        bool disabled;
+    };
+    static constexpr std::size_t alloc_size =
+        block_size < sizeof(block) ? sizeof(block) : block_size;
+    static constexpr std::size_t max_free = 256;
+
+    /*!
+     * 自明なデストラクタを持つのでスレッド終了処理中もアクセスできる
+     */
+    static free_list &local() {
+        static thread_local free_list list{nullptr, 0, false};
+        return list;
+    }
+    /*!
+     * スレッド終了時にフリーリストを解放し、以降のプールの使用を止める
+     */
+    struct cleaner {
+        ~cleaner() {
+            free_list &list = local();
+            list.disabled = true;
+            while (list.head) {
+                block *b = list.head;
+                list.head = b->next;
+                ::operator delete(b);
+            }
+            list.count = 0;
+        }
+    };
 
-    explicit life_validator(const void *ptr, bool valid = true)
-        : ptr_(ptr), valid_(valid) {}
+  public:
+    static void *allocate() {
+        free_list &list = local();
+        if (list.head) {
+            block *b = list.head;
+            list.head = b->next;
+            --list.count;
+            return b;
+        }
+        return ::operator new(alloc_size);
+    }
+    static void deallocate(void *p) noexcept {
+        free_list &list = local();
+        if (list.disabled || list.count >= max_free) {
+            ::operator delete(p);
+            return;
+        }
+        static thread_local cleaner c;
+        static_cast<void>(c);
+        block *b = static_cast<block *>(p);
+        b->next = list.head;
+        list.head = b;
+        ++list.count;
+    }
 };
+
+/*!
+ * \brief life_state, life_epoch の参照カウント
+ *
+ * Y3C_SINGLE_THREADED が有効な場合はatomicでない整数を使う。
+ *
+ */
+class life_ref_count {
+#if Y3C_SINGLE_THREADED
+    std::size_t count_;
+#else
+    std::atomic<std::size_t> count_;
+#endif
+
+  public:
+    life_ref_count() noexcept : count_(0) {}
+
+#if Y3C_SINGLE_THREADED
+    void increment() noexcept { ++count_; }
+    bool decrement() noexcept { return --count_ == 0; }
+    std::size_t load() const noexcept { return count_; }
+#else
+    void increment() noexcept {
+        count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    bool decrement() noexcept {
+        return count_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+    std::size_t load() const noexcept {
+        return count_.load(std::memory_order_relaxed);
+    }
+#endif
+};
+/*!
+ * \brief 複数スレッドから読まれる life_state などの値
+ *
+ * 書き込みはreleaseで、読み込みはacquireで行う。
+ * Y3C_SINGLE_THREADED が有効な場合はただの変数。
+ *
+ */
+template <typename T>
+class life_atomic {
+#if Y3C_SINGLE_THREADED
+    T value_;
+#else
+    std::atomic<T> value_;
+#endif
+
+  public:
+    explicit life_atomic(T value) noexcept : value_(value) {}
+    life_atomic(const life_atomic &) = delete;
+    life_atomic &operator=(const life_atomic &) = delete;
+
+#if Y3C_SINGLE_THREADED
+    T load() const noexcept { return value_; }
+    void store(T value) noexcept { value_ = value; }
+    /*!
+     * \brief 値がexpectedと等しければdesiredに置き換える
+     * \return 置き換えた場合true
+     */
+    bool compare_exchange(T expected, T desired) noexcept {
+        if (value_ != expected) {
+            return false;
+        }
+        value_ = desired;
+        return true;
+    }
+#else
+    T load() const noexcept { return value_.load(std::memory_order_acquire); }
+    void store(T value) noexcept {
+        value_.store(value, std::memory_order_release);
+    }
+    bool compare_exchange(T expected, T desired) noexcept {
+        return value_.compare_exchange_strong(
+            expected, desired, std::memory_order_acq_rel,
+            std::memory_order_acquire);
+    }
+#endif
+};
+/*!
+ * \brief life_state の無効化の記録を保護するロック
+ *
+ * Y3C_SINGLE_THREADED が有効な場合は何もしない。
+ *
+ */
+#if Y3C_SINGLE_THREADED
+struct life_mutex {
+    void lock() noexcept {}
+    void unlock() noexcept {}
+};
+#else
+using life_mutex = std::mutex;
+#endif
+struct life_lock_guard {
+    life_mutex &m;
+    explicit life_lock_guard(life_mutex &m) : m(m) { m.lock(); }
+    life_lock_guard(const life_lock_guard &) = delete;
+    life_lock_guard &operator=(const life_lock_guard &) = delete;
+    ~life_lock_guard() { m.unlock(); }
+};
+
+/*!
+ * \brief 同じ世代のvalidatorの数を数えるノード
+ *
+ * life_state は現在の世代のノードを1つ持ち、
+ * validatorを作るたびにそのノードの参照カウントを増やす。
+ * 範囲を更新するときに現在の世代のvalidatorがあれば、
+ * 新しい世代のノードに切り替えて古いノードをリストに残す。
+ *
+ * 古いノードは最後のvalidatorが破棄されたときにリストから外し、
+ * そのノードのvalidatorしか参照しない無効化の記録も一緒に削除する。
+ * したがって記録の数は変更の回数ではなく、
+ * 残っているvalidatorの世代の数で抑えられる。
+ *
+ * ノードと記録のリストは life_state の mutex_ で保護する。
+ *
+ */
+class life_epoch {
+    life_ref_count ref_count_;
+    std::size_t generation_;
+    life_state *state_;
+    life_epoch *older_, *newer_;
+
+    friend class life_state;
+
+  public:
+    life_epoch(std::size_t generation, life_state *state, life_epoch *older)
+        : ref_count_(), generation_(generation), state_(state), older_(older),
+          newer_(nullptr) {
+        ref_count_.increment();
+        if (older_) {
+            older_->newer_ = this;
+        }
+    }
+    life_epoch(const life_epoch &) = delete;
+    life_epoch &operator=(const life_epoch &) = delete;
+    ~life_epoch() = default;
+
+    static void *operator new(std::size_t size) {
+        y3c_assert_internal(size == sizeof(life_epoch));
+        return fixed_size_pool<sizeof(life_epoch)>::allocate();
+    }
+    static void operator delete(void *p) noexcept {
+        fixed_size_pool<sizeof(life_epoch)>::deallocate(p);
+    }
+
+    void add_ref() noexcept { ref_count_.increment(); }
+    /*!
+     * \brief 参照を1つ解放し、0になった場合はstateのリストから削除する
+     */
+    static void release(life_epoch *epoch);
+    std::size_t use_count() const noexcept { return ref_count_.load(); }
+    std::size_t generation() const noexcept { return generation_; }
+};
+
+/*!
+ * \brief イテレータの有効性を判定するための情報
+ *
+ * イテレータ側で値として持ち、最後にチェックした時点での世代の
+ * life_epoch を参照する。
+ * life_state 側で世代が進んでいなければ再チェックは不要。
+ * 位置はイテレータ自身が持っているポインタを使う。
+ *
+ * 無効になったイテレータや寿命のチェックが無効な場合は何も参照しない。
+ * 参照している life_state より先に破棄すること
+ * (イテレータでは observer より後ろのメンバーにする)。
+ *
+ */
+class life_validator {
+    life_epoch *epoch_;
+
+  public:
+    life_validator() noexcept : epoch_(nullptr) {}
+    /*!
+     * \param epoch 参照カウントを1つ増やしたノード
+     */
+    explicit life_validator(life_epoch *epoch) noexcept : epoch_(epoch) {}
+    life_validator(const life_validator &other) noexcept
+        : epoch_(other.epoch_) {
+        if (epoch_) {
+            epoch_->add_ref();
+        }
+    }
+    life_validator(life_validator &&other) noexcept : epoch_(other.epoch_) {
+        other.epoch_ = nullptr;
+    }
+    life_validator &operator=(const life_validator &other) {
+        life_validator(other).swap(*this);
+        return *this;
+    }
+    life_validator &operator=(life_validator &&other) {
+        life_validator(std::move(other)).swap(*this);
+        return *this;
+    }
+    ~life_validator() {
+        if (epoch_) {
+            life_epoch::release(epoch_);
+        }
+    }
+
+    void swap(life_validator &other) noexcept {
+        life_epoch *tmp = epoch_;
+        epoch_ = other.epoch_;
+        other.epoch_ = tmp;
+    }
+    bool valid() const noexcept { return epoch_ != nullptr; }
+    const life_epoch *epoch() const noexcept { return epoch_; }
+};
+
+/*!
+ * \brief オブジェクトの生存状態と有効範囲
+ *
+ * 所有者(life)が更新し、observerが複数のスレッドから同時に読むことがある。
+ *
+ * * alive_, begin_, end_, current_ はatomicで、
+ * ロックせずに読める。
+ * * 無効化の記録(upper_, lower_)と古い世代の life_epoch は mutex_ で保護する。
+ * is_valid() はvalidatorの世代が最新であれば記録を見る必要がないので、
+ * 更新が無い間はロックを取らない。
+ * * 世代は、現在の世代のvalidatorがある場合にだけ進める。
+ * 無ければ、記録は現在の世代のものとして追加し、最後の記録とまとめる。
+ * 古い世代のvalidatorも無ければ記録自体を省略する。
+ * * 古い世代のvalidatorが全て破棄されると、
+ * その世代からしか参照されない記録を削除する (life_epoch)。
+ * したがって記録の数は保持されているイテレータの世代の数で抑えられ、
+ * イテレータを持ったまま変更とイテレータの作成を繰り返しても増えない。
+ *
+ * 所有者による更新そのものは1つのスレッドから行われる前提
+ * (コンテナを変更しながら別スレッドで読むのはコンテナ自体のデータ競合)。
+ *
+ */
 class life_state {
-    bool alive_;
-    const void *begin_, *end_;
-    std::vector<std::shared_ptr<life_validator>> validators_;
+    /*!
+     * \brief 所有者が最後に追加した記録
+     *
+     * 所有者のスレッドだけが読み書きし、
+     * 同じ世代でこれより緩い記録の追加をロックせずに省略するのに使う。
+     * 他のスレッドが記録を削除した後も、
+     * 残っているvalidatorに対しては同じか厳しい記録が残るので、
+     * 省略してよいという判断は変わらない。
+     *
+     */
+    struct recorded {
+        std::size_t generation;
+        /*!
+         * 古い世代のvalidatorが無く、この世代の記録は全て省略できる
+         */
+        bool all;
+        const void *upper, *lower;
+
+        bool covers(std::size_t g, const void *hi, const void *lo) const {
+            return g == generation &&
+                   (all || ((!hi || (upper && !(hi < upper))) &&
+                            (!lo || (lower && !(lower < lo)))));
+        }
+    };
+    static recorded no_record() {
+        return {static_cast<std::size_t>(-1), false, nullptr, nullptr};
+    }
+
+    life_ref_count ref_count_;
+    func_name::type_name_func type_name_;
+    life_atomic<bool> alive_;
+    life_atomic<const void *> begin_, end_;
+    life_atomic<life_epoch *> current_;
+    mutable life_mutex mutex_;
+    life_invalidation_list<true> upper_;
+    life_invalidation_list<false> lower_;
+    recorded recorded_;
+
+    /*!
+     * \brief 世代を1つ進める
+     *
+     * mutex_ をロックした状態で呼ぶ。
+     * 古いノードは残っているvalidatorが破棄されるまでリストに残り、
+     * その間このstateの参照を1つ持つ。
+     *
+     */
+    life_epoch *next_epoch() {
+        life_epoch *old = current_.load();
+        life_epoch *epoch = new life_epoch(old->generation() + 1, this, old);
+        current_.store(epoch);
+        if (old->ref_count_.decrement()) {
+            remove_epoch(old);
+        } else {
+            add_ref();
+        }
+        return epoch;
+    }
+    /*!
+     * \brief validatorが無くなった古いノードをリストから外す
+     *
+     * mutex_ をロックした状態で呼ぶ。
+     * 1つ前のノードが残っていれば、それが参照する最初の記録だけを残す。
+     * ノードが持っていたstateの参照は呼び出し側で解放する。
+     *
+     */
+    void remove_epoch(life_epoch *epoch) {
+        life_epoch *older = epoch->older_, *newer = epoch->newer_;
+        std::size_t after = older ? older->generation() : 0;
+        upper_.prune(older != nullptr, after, newer->generation());
+        lower_.prune(older != nullptr, after, newer->generation());
+        if (older) {
+            older->newer_ = newer;
+        }
+        newer->older_ = older;
+        delete epoch;
+    }
+
+    /*!
+     * \brief 現在の世代の記録を追加する
+     *
+     * mutex_ をロックした状態で呼ぶ
+     *
+     */
+    void record(const life_epoch *epoch, const void *hi, const void *lo) {
+        std::size_t generation = epoch->generation();
+        if (!epoch->older_) {
+            // 記録を参照する古い世代のvalidatorが無い
+            recorded_ = {generation, true, nullptr, nullptr};
+            return;
+        }
+        if (recorded_.generation != generation) {
+            recorded_ = {generation, false, nullptr, nullptr};
+        }
+        if (hi) {
+            upper_.push(generation, hi);
+            recorded_.upper = upper_.back_bound();
+        }
+        if (lo) {
+            lower_.push(generation, lo);
+            recorded_.lower = lower_.back_bound();
+        }
+    }
+    /*!
+     * \brief validatorが無くなった古いノードを削除する
+     *
+     * life_epoch::release() から、任意のスレッドで呼ばれる
+     *
+     */
+    static void remove_epoch_of(life_epoch *epoch) {
+        life_state *state = epoch->state_;
+        {
+            life_lock_guard lock(state->mutex_);
+            state->remove_epoch(epoch);
+        }
+        if (state->release()) {
+            delete state;
+        }
+    }
+
+    friend class life_epoch;
 
   public:
-    life_state(const void *begin, const void *end)
-        : alive_(true), begin_(begin), end_(end) {}
+    life_state(const void *begin, const void *end,
+               func_name::type_name_func type_name)
+        : ref_count_(), type_name_(type_name), alive_(true), begin_(begin),
+          end_(end),
+          // 寿命のチェックをしない場合はvalidatorを作らない
+          current_(check_lifetime ? new life_epoch(0, this, nullptr)
+                                  : nullptr),
+          mutex_(), upper_(), lower_(), recorded_(no_record()) {}
     life_state(const life_state &) = delete;
     life_state &operator=(const life_state &) = delete;
     life_state(life_state &&) = delete;
     life_state &operator=(life_state &&) = delete;
-    ~life_state() = default;
+    /*!
+     * 古いノードはstateを参照しているので、残っているのは現在のノードだけ
+     */
+    ~life_state() { delete current_.load(); }
+
+    static void *operator new(std::size_t size) {
+        y3c_assert_internal(size == sizeof(life_state));
+        return fixed_size_pool<sizeof(life_state)>::allocate();
+    }
+    static void operator delete(void *p) noexcept {
+        fixed_size_pool<sizeof(life_state)>::deallocate(p);
+    }
+
+    void add_ref() noexcept { ref_count_.increment(); }
+    /*!
+     * \return 参照カウントが0になった場合true
+     */
+    bool release() noexcept { return ref_count_.decrement(); }
+    std::size_t use_count() const noexcept { return ref_count_.load(); }
 
     void destroy() {
-        alive_ = false;
-        for (const auto &validator : validators_) {
-            validator->valid_ = false;
+        alive_.store(false);
+        clear_invalidations();
+    }
+    /*!
+     * \brief 別の範囲の状態として初期化し直す
+     *
+     * 参照しているobserverが無い場合に、
+     * destroy() して新しいstateを作る代わりや、
+     * update_range() で無効化を記録する代わりに呼ぶ。
+     *
+     * 他のスレッドから読まれることもvalidatorが残っていることもないので、
+     * ロックを取らず、記録が無ければ何もしない
+     * (push_back() のたびに呼ばれるので軽くしておく)。
+     *
+     */
+    void reset(const void *new_begin, const void *new_end) {
+        if (upper_.size() != 0 || lower_.size() != 0) {
+            upper_.clear();
+            lower_.clear();
         }
-        validators_.clear();
+        recorded_ = no_record();
+        begin_.store(new_begin);
+        end_.store(new_end);
     }
-    const void *begin() const { return begin_; }
-    const void *end() const { return end_; }
-    void push_validator(const std::shared_ptr<life_validator> &v) {
-        validators_.push_back(v);
+    const void *begin() const { return begin_.load(); }
+    const void *end() const { return end_.load(); }
+    /*!
+     * \brief 現在の世代のvalidatorを作る
+     *
+     * 範囲の変更と同時に呼ばれることは無い (コンテナ自体へのデータ競合になる)。
+     *
+     */
+    life_validator make_validator() const {
+        life_epoch *epoch = current_.load();
+        epoch->add_ref();
+        return life_validator(epoch);
+    }
+    /*!
+     * \brief validatorが現在の世代のものかどうか
+     */
+    bool is_current(const life_validator &v) const {
+        return v.epoch() == current_.load();
     }
+    /*!
+     * \brief この範囲を指すイテレータの型名を返す関数 (無い場合nullptr)
+     */
+    func_name::type_name_func type_name() const { return type_name_; }
+    /*!
+     * \brief 範囲を更新する
+     *
+     * 既存のイテレータを走査するのではなく、
+     * 必要なら世代を1つ進めてどの範囲が無効になったかだけを記録する。
+     * イテレータ側は次にチェックされたときに is_valid() で判定する。
+     *
+     * * 先頭が後ろにずれた場合、新しい先頭より前が無効になる
+     * * 末尾が変わった場合、古い末尾と新しい末尾の小さい方以降が無効になる
+     * * invalidate_from が指定された場合、それ以降が無効になる
+     *
+     * 記録の追加と世代の切り替えはロックした中で行うので、
+     * 古い世代のvalidatorを判定するスレッドは必ずその記録を参照できる。
+     *
+     */
     void update_range(const void *new_begin, const void *new_end,
                       const void *invalidate_from = nullptr) {
-        bool end_changed = end_ != new_end;
-        for (auto it = validators_.begin(); it != validators_.end();) {
-            auto validator = *it;
-            if (validator->ptr_ < begin_ || validator->ptr_ > end_ ||
-                validator->ptr_ < new_begin || validator->ptr_ > new_end ||
-                (end_changed && validator->ptr_ == end_) ||
-                (end_changed && validator->ptr_ == new_end) ||
-                (invalidate_from != nullptr &&
-                 validator->ptr_ >= invalidate_from)) {
-                validator->valid_ = false;
-                it = validators_.erase(it);
-            } else {
-                ++it;
+        const void *old_begin = begin_.load(), *old_end = end_.load();
+        const void *hi = nullptr;
+        if (old_end != new_end) {
+            hi = new_end < old_end ? new_end : old_end;
+        }
+        if (invalidate_from != nullptr && (!hi || invalidate_from < hi)) {
+            hi = invalidate_from;
+        }
+        const void *lo = old_begin < new_begin ? new_begin : nullptr;
+        // 寿命のチェックをしない場合は記録しても使われない
+        if (check_lifetime && (hi || lo)) {
+            life_epoch *epoch = current_.load();
+            // 現在の世代のノードはstate自身が1つ参照している
+            bool observed = epoch->use_count() > 1;
+            if (observed || !recorded_.covers(epoch->generation(), hi, lo)) {
+                life_lock_guard lock(mutex_);
+                if (observed) {
+                    epoch = next_epoch();
+                }
+                record(epoch, hi, lo);
             }
         }
-        begin_ = new_begin;
-        end_ = new_end;
+        begin_.store(new_begin);
+        end_.store(new_end);
+    }
+    /*!
+     * \brief 無効化の記録を破棄する
+     *
+     * validatorを持つ observer が1つも無い場合に呼ぶ
+     *
+     */
+    void clear_invalidations() {
+        life_lock_guard lock(mutex_);
+        upper_.clear();
+        lower_.clear();
+        recorded_ = no_record();
+    }
+    std::size_t invalidations_size() const {
+        life_lock_guard lock(mutex_);
+        return upper_.size() + lower_.size();
+    }
+    /*!
+     * \brief validatorの世代以降の更新で、ptrが無効化されていないかを判定する
+     *
+     * validatorの世代が最新ならロックを取らずに判定できる
+     *
+     */
+    bool is_valid(const life_validator &v, const void *ptr) const {
+        if (!alive() || !v.valid()) {
+            return false;
+        }
+        if (is_current(v)) {
+            return true;
+        }
+        life_lock_guard lock(mutex_);
+        std::size_t generation = v.epoch()->generation();
+        return !upper_.invalidates(ptr, generation) &&
+               !lower_.invalidates(ptr, generation);
+    }
+    bool alive() const { return alive_.load(); }
+    bool in_range(const void *ptr) const {
+        return begin_.load() <= ptr && ptr < end_.load();
     }
-    bool alive() const { return alive_; }
-    bool in_range(const void *ptr) const { return begin_ <= ptr && ptr < end_; }
     bool in_range_including_end(const void *ptr) const {
-        return begin_ <= ptr && ptr <= end_;
+        return begin_.load() <= ptr && ptr <= end_.load();
     }
     bool in_range(const void *begin, const void *end) const {
-        return this->begin_ <= begin && begin <= end && end <= this->end_;
+        return begin_.load() <= begin && begin <= end && end <= end_.load();
     }
     template <typename T>
     std::size_t size() const {
-        return static_cast<const T *>(end_) - static_cast<const T *>(begin_);
+        return static_cast<const T *>(end_.load()) -
+               static_cast<const T *>(begin_.load());
     }
     template <typename T>
     std::ptrdiff_t index_of(T *ptr) const {
-        return ptr - static_cast<const T *>(begin_);
+        return ptr - static_cast<const T *>(begin_.load());
+    }
+};
+
+inline void life_epoch::release(life_epoch *epoch) {
+    if (epoch->ref_count_.decrement()) {
+        life_state::remove_epoch_of(epoch);
+    }
+}
+
+/*!
+ * \brief life_state を参照カウントで管理するポインタ
+ *
+ * std::shared_ptr と違い制御ブロックを別に確保せず、
+ * life_state 自体が持つ参照カウントを使う。
+ *
+ */
+class life_state_ref {
+    life_state *state_;
+
+    /*!
+     * 最後の参照が消えるのはまれなので、
+     * 参照を持つ値を返す関数のたびに展開されないよう別の関数にしている
+     */
+    static Y3C_COLD void delete_state(life_state *state) { delete state; }
+
+  public:
+    life_state_ref(std::nullptr_t = nullptr) noexcept : state_(nullptr) {}
+    explicit life_state_ref(life_state *state) noexcept : state_(state) {
+        if (state_) {
+            state_->add_ref();
+        }
+    }
+    life_state_ref(const life_state_ref &other) noexcept
+        : state_(other.state_) {
+        if (state_) {
+            state_->add_ref();
+        }
+    }
+    life_state_ref(life_state_ref &&other) noexcept : state_(other.state_) {
+        other.state_ = nullptr;
+    }
+    life_state_ref &operator=(const life_state_ref &other) noexcept {
+        life_state_ref(other).swap(*this);
+        return *this;
+    }
+    life_state_ref &operator=(life_state_ref &&other) noexcept {
+        life_state_ref(std::move(other)).swap(*this);
+        return *this;
+    }
+    ~life_state_ref() {
+        if (state_ && state_->release()) {
+            delete_state(state_);
+        }
+    }
+
+    void swap(life_state_ref &other) noexcept {
+        life_state *tmp = state_;
+        state_ = other.state_;
+        other.state_ = tmp;
+    }
+    life_state *get() const noexcept { return state_; }
+    life_state *operator->() const noexcept { return state_; }
+    explicit operator bool() const noexcept { return state_ != nullptr; }
+    std::size_t use_count() const noexcept {
+        return state_ ? state_->use_count() : 0;
+    }
+    bool operator==(const life_state_ref &other) const noexcept {
+        return state_ == other.state_;
+    }
+    bool operator!=(const life_state_ref &other) const noexcept {
+        return state_ != other.state_;
     }
 };
 
@@ -87,10 +801,9 @@ class life_state {
  *
  */
 class life_observer {
-    std::shared_ptr<life_state> state_;
+    life_state_ref state_;
 
-    explicit life_observer(const std::shared_ptr<life_state> &state)
-        : state_(state) {}
+    explicit life_observer(life_state_ref state) : state_(std::move(state)) {}
 
   public:
     /*!
@@ -100,27 +813,96 @@ class life_observer {
     explicit life_observer(std::nullptr_t) : state_(nullptr) {}
     life_observer(const life_observer &) = default;
     life_observer &operator=(const life_observer &) = default;
+    life_observer(life_observer &&) = default;
+    life_observer &operator=(life_observer &&) = default;
     ~life_observer() = default;
 
-    const std::shared_ptr<life_validator> &
-    push_validator(const std::shared_ptr<life_validator> &v) const {
-        state_->push_validator(v);
-        return v;
+    /*!
+     * \brief 現在の世代のvalidatorを作成する
+     *
+     * 寿命のチェックが無効な場合はstateに触れない
+     *
+     */
+    life_validator make_validator(bool valid = true) const {
+        if (!check_lifetime || !valid || !state_) {
+            return life_validator();
+        }
+        return state_->make_validator();
+    }
+    /*!
+     * \brief ptrを指すvalidatorが有効かどうかを判定する
+     */
+    bool is_valid(const life_validator &v, const void *ptr) const {
+        return state_ && state_->is_valid(v, ptr);
+    }
+    /*!
+     * \brief 現在の世代までの無効化を反映する
+     *
+     * ptrはvalidatorを最後に更新した時点での位置
+     *
+     */
+    void update_validator(life_validator &v, const void *ptr) const {
+        // 判定の途中で世代が進んだ場合は、次回のチェックで再判定される
+        if (!is_valid(v, ptr)) {
+            v = life_validator();
+        } else if (!state_->is_current(v)) {
+            v = state_->make_validator();
+        }
     }
     const void *begin() const { return state_->begin(); }
     const void *end() const { return state_->end(); }
+    /*!
+     * \brief この範囲を指すイテレータの型名を返す関数
+     *
+     * nullptrの場合や、型名を渡さずに作ったlifeの場合はnullptrを返す
+     *
+     */
+    func_name::type_name_func type_name() const {
+        return state_ ? state_->type_name() : nullptr;
+    }
+    /*!
+     * \brief エラーメッセージ用に、observerから範囲を指すイテレータの型名を取得する
+     *
+     * func_name の type_name_of として使う。
+     * 型名が分からない場合は fallback を返す。
+     *
+     */
+    template <const std::string &(*fallback)()>
+    static const std::string &iter_type_name_of(const void *observer) {
+        func_name::type_name_func type_name =
+            static_cast<const life_observer *>(observer)->type_name();
+        return type_name ? type_name() : fallback();
+    }
+    /*!
+     * \brief 同じ対象を観測しているかどうか
+     */
+    bool operator==(const life_observer &other) const {
+        return state_ == other.state_;
+    }
+    bool operator!=(const life_observer &other) const {
+        return state_ != other.state_;
+    }
+    /*!
+     * \brief 保持している無効化の記録の数 (テスト用)
+     */
+    std::size_t invalidations_size() const {
+        return state_ ? state_->invalidations_size() : 0;
+    }
     template <typename element_type>
-    element_type *assert_ptr(element_type *ptr, const std::string &func,
+    element_type *assert_ptr(element_type *ptr, const func_name &func,
                              internal::skip_trace_tag = {}) const {
+        if (!check_sampled()) {
+            return ptr;
+        }
         // array<T, 0> の参照の場合 ptr_ = nullptr, alive = arrayの寿命
         // になる場合があるが、 その場合はnullptrアクセスエラーとしない
-        if (!state_) {
+        if (check_nullptr && !state_) {
             y3c::internal::terminate_ub_access_nullptr(func);
         }
-        if (!state_->alive()) {
+        if (check_lifetime && !state_->alive()) {
             y3c::internal::terminate_ub_access_deleted(func);
         }
-        if (!state_->in_range(ptr)) {
+        if (check_bounds && !state_->in_range(ptr)) {
             y3c::internal::terminate_ub_out_of_range(
                 func, state_->size<element_type>(), state_->index_of(ptr));
         }
@@ -128,19 +910,21 @@ class life_observer {
     }
     template <typename element_type>
     element_type *assert_iter(const contiguous_iterator<element_type> &iter,
-                              const std::string &func,
+                              const func_name &func,
                               internal::skip_trace_tag = {}) const {
-        if (!state_) {
+        if (!check_sampled()) {
+            return iter.ptr_;
+        }
+        if (check_nullptr && !state_) {
             y3c::internal::terminate_ub_access_nullptr(func);
         }
-        if (!state_->alive()) {
+        if (check_lifetime && !state_->alive()) {
             y3c::internal::terminate_ub_access_deleted(func);
         }
-        y3c_assert_internal(iter.validator_);
-        if (!iter.validator_->valid_) {
+        if (check_lifetime && !state_->is_valid(iter.validator_, iter.ptr_)) {
             y3c::internal::terminate_ub_invalid_iter(func);
         }
-        if (!state_->in_range(iter.ptr_)) {
+        if (check_bounds && !state_->in_range(iter.ptr_)) {
             y3c::internal::terminate_ub_out_of_range(
                 func, state_->size<element_type>(),
                 state_->index_of(iter.ptr_));
@@ -150,45 +934,106 @@ class life_observer {
     template <typename element_type>
     element_type *
     assert_iter_including_end(const contiguous_iterator<element_type> &iter,
-                              const std::string &func,
+                              const func_name &func,
                               internal::skip_trace_tag = {}) const {
-        if (!state_) {
+        if (!check_sampled()) {
+            return iter.ptr_;
+        }
+        if (check_nullptr && !state_) {
             y3c::internal::terminate_ub_access_nullptr(func);
         }
-        if (!state_->alive()) {
+        if (check_lifetime && !state_->alive()) {
             y3c::internal::terminate_ub_access_deleted(func);
         }
-        y3c_assert_internal(iter.validator_);
-        if (!iter.validator_->valid_) {
+        if (check_lifetime && !state_->is_valid(iter.validator_, iter.ptr_)) {
             y3c::internal::terminate_ub_invalid_iter(func);
         }
-        if (!state_->in_range_including_end(iter.ptr_)) {
+        if (check_bounds && !state_->in_range_including_end(iter.ptr_)) {
             y3c::internal::terminate_ub_out_of_range(
                 func, state_->size<element_type>(),
                 state_->index_of(iter.ptr_));
         }
         return iter.ptr_;
     }
+    /*!
+     * \brief 逆イテレータが指す要素 (iterの1つ前) をチェックする
+     *
+     * iter は逆イテレータの base()。
+     * 範囲外のポインタを作らないよう、iter - 1 を計算する前に比較する。
+     *
+     */
+    template <typename element_type>
+    element_type *
+    assert_reverse_iter(const contiguous_iterator<element_type> &iter,
+                        const func_name &func,
+                        internal::skip_trace_tag = {}) const {
+        if (!check_sampled()) {
+            return iter.ptr_ - 1;
+        }
+        if (check_nullptr && !state_) {
+            y3c::internal::terminate_ub_access_nullptr(func);
+        }
+        if (check_lifetime && !state_->alive()) {
+            y3c::internal::terminate_ub_access_deleted(func);
+        }
+        if (check_lifetime && !state_->is_valid(iter.validator_, iter.ptr_)) {
+            y3c::internal::terminate_ub_invalid_iter(func);
+        }
+        if (check_bounds && (!state_->in_range_including_end(iter.ptr_) ||
+                             state_->begin() == iter.ptr_)) {
+            y3c::internal::terminate_ub_out_of_range(
+                func, state_->size<element_type>(),
+                state_->index_of(iter.ptr_) - 1);
+        }
+        return iter.ptr_ - 1;
+    }
+    /*!
+     * \brief [begin, end) がすべて範囲内であることをチェックする
+     *
+     * 生ポインタの範囲に対して1回で行う (y3c/numeric など)
+     *
+     */
+    template <typename element_type>
+    void assert_range_ptr(element_type *begin, element_type *end,
+                          const func_name &func,
+                          internal::skip_trace_tag = {}) const {
+        if (!check_sampled()) {
+            return;
+        }
+        if (check_nullptr && !state_) {
+            y3c::internal::terminate_ub_access_nullptr(func);
+        }
+        if (check_lifetime && !state_->alive()) {
+            y3c::internal::terminate_ub_access_deleted(func);
+        }
+        if (check_bounds && !state_->in_range(begin, end)) {
+            y3c::internal::terminate_ub_out_of_range(
+                func, state_->size<element_type>(), state_->index_of(begin),
+                state_->index_of(end));
+        }
+    }
     template <typename element_type>
     void assert_range_iter(const contiguous_iterator<element_type> &begin,
                            const contiguous_iterator<element_type> &end,
-                           const std::string &func,
+                           const func_name &func,
                            internal::skip_trace_tag = {}) const {
-        if (!state_) {
+        if (!check_sampled()) {
+            return;
+        }
+        if (check_nullptr && !state_) {
             y3c::internal::terminate_ub_access_nullptr(func);
         }
-        if (!state_->alive()) {
+        if (check_lifetime && !state_->alive()) {
             y3c::internal::terminate_ub_access_deleted(func);
         }
-        y3c_assert_internal(begin.validator_);
-        if (!begin.validator_->valid_) {
+        if (check_lifetime &&
+            !state_->is_valid(begin.validator_, begin.ptr_)) {
             y3c::internal::terminate_ub_invalid_iter(func);
         }
-        y3c_assert_internal(end.validator_);
-        if (!end.validator_->valid_) {
+        if (check_lifetime && !state_->is_valid(end.validator_, end.ptr_)) {
             y3c::internal::terminate_ub_invalid_iter(func);
         }
-        if (!state_->in_range(begin.ptr_, end.ptr_)) {
+        if (check_bounds && !state_->in_range(begin.ptr_, end.ptr_)) {
             y3c::internal::terminate_ub_out_of_range(
                 func, state_->size<element_type>(),
                 state_->index_of(begin.ptr_), state_->index_of(end.ptr_));
@@ -196,6 +1041,73 @@ class life_observer {
     }
 
     friend class life;
+    friend class object_life;
+};
+
+/*!
+ * \brief life_state の参照を1つ持ち、最初に必要になったときに作成する
+ *
+ * constなコンテナを複数スレッドから同時に読む場合に備えて、
+ * 作成はスレッドセーフにしてある。
+ *
+ */
+class life_state_slot {
+    mutable life_atomic<life_state *> state_;
+
+  public:
+    life_state_slot() noexcept : state_(nullptr) {}
+    life_state_slot(const life_state_slot &) = delete;
+    life_state_slot &operator=(const life_state_slot &) = delete;
+    ~life_state_slot() { replace(nullptr); }
+
+    void swap(life_state_slot &other) noexcept {
+        life_state *tmp = state_.load();
+        state_.store(other.state_.load());
+        other.state_.store(tmp);
+    }
+    life_state *get() const { return state_.load(); }
+    life_state *get_or_create(const void *begin, const void *end,
+                              func_name::type_name_func type_name) const {
+        life_state *state = state_.load();
+        if (!state) {
+            state = create(begin, end, type_name);
+        }
+        return state;
+    }
+    /*!
+     * \brief stateを作成する
+     *
+     * コンテナごとに最初の1回しか呼ばれないので、
+     * 要素アクセスのたびに展開されないよう別の関数にしている
+     *
+     */
+    Y3C_COLD life_state *create(const void *begin, const void *end,
+                                func_name::type_name_func type_name) const {
+        life_state *new_state = new life_state(begin, end, type_name);
+        new_state->add_ref();
+        if (state_.compare_exchange(nullptr, new_state)) {
+            return new_state;
+        }
+        // 別のスレッドが先に作成した
+        delete new_state;
+        return state_.load();
+    }
+    /*!
+     * \brief 現在のstateを destroy() して別のstateに置き換える
+     */
+    void replace(life_state *new_state) {
+        life_state *state = state_.load();
+        if (state) {
+            state->destroy();
+            if (state->release()) {
+                delete state;
+            }
+        }
+        if (new_state) {
+            new_state->add_ref();
+        }
+        state_.store(new_state);
+    }
 };
 
 /*!
@@ -203,57 +1115,118 @@ class life_observer {
  *
  * オブジェクトの所有者はlifeまたはshared_ptr<life>を持つ。
  *
+ * stateは最初にobserverを作るときに作成する。
+ *
+ * ムーブするとstateごと移るので、ムーブ元のobserverはムーブ先で有効なままになる
+ * (ムーブ元は空の範囲になる)。
+ *
  */
 class life {
     const void *begin, *end;
-    mutable std::shared_ptr<life_state> state_;
-
-    std::shared_ptr<life_state> init_state() const {
-        if (!state_) {
-            state_ = std::shared_ptr<life_state>(new life_state(begin, end));
-        }
-        return state_;
-    }
+    func_name::type_name_func type_name;
+    life_state_slot state_;
 
   public:
-    explicit life(const void *begin, const void *end)
-        : begin(begin), end(end), state_(nullptr) {}
+    /*!
+     * \param type_name この範囲を指すイテレータの型名を返す関数
+     */
+    explicit life(const void *begin, const void *end,
+                  func_name::type_name_func type_name = nullptr)
+        : begin(begin), end(end), type_name(type_name), state_() {}
     template <typename T>
     explicit life(T *begin) : life(begin, begin + 1) {}
     life(const life &) = delete;
     life &operator=(const life &) = delete;
-    life(life &&) = delete;
-    life &operator=(life &&) = delete;
-    ~life() {
-        if (state_) {
-            state_->destroy();
-        }
+    life(life &&other) noexcept
+        : begin(other.begin), end(other.end), type_name(other.type_name),
+          state_() {
+        state_.swap(other.state_);
+        other.begin = nullptr;
+        other.end = nullptr;
+    }
+    /*!
+     * 以前のstateは破棄される(以前のobserverは無効になる)
+     */
+    life &operator=(life &&other) noexcept {
+        life(std::move(other)).swap(*this);
+        return *this;
+    }
+    ~life() = default;
+
+    void swap(life &other) noexcept {
+        std::swap(begin, other.begin);
+        std::swap(end, other.end);
+        std::swap(type_name, other.type_name);
+        state_.swap(other.state_);
     }
 
-    life_observer observer() const { return life_observer(init_state()); }
+    life_observer observer() const {
+        return life_observer(
+            life_state_ref(state_.get_or_create(begin, end, type_name)));
+    }
     /*!
      * 新しい範囲が以前の範囲と被っていれば範囲を更新し(observerは有効のまま)、
      * まったく異なる範囲であればリセットする(以前のobserverは無効になる)
+     *
+     * * まだobserverを作っていない場合は範囲を覚えておくだけ
+     * * リセットする際、以前のstateを参照しているobserverが無ければ
+     * 同じstateを使い回す
+     *
      * \param invalidate_from 更新された範囲の先頭
      * (nullptrでない場合、これより後の範囲を追加で無効化する)
      */
     void update(const void *begin, const void *end,
                 const void *invalidate_from = nullptr) {
-        init_state();
-        if ((begin < state_->begin() && end <= state_->begin()) ||
-            (begin >= state_->end() && end > state_->end())) {
-            state_->destroy();
-            state_ = std::shared_ptr<life_state>(new life_state(begin, end));
+        life_state *state = state_.get();
+        if (!state) {
+            this->begin = begin;
+            this->end = end;
+            return;
+        }
+        if (state->use_count() == 1) {
+            // このlife以外にstateを参照しているobserverが無いので、
+            // 無効化を記録しても参照するvalidatorが存在しない
+            state->reset(begin, end);
+        } else if ((begin < state->begin() && end <= state->begin()) ||
+                   (begin >= state->end() && end > state->end())) {
+            state_.replace(new life_state(begin, end, type_name));
         } else {
-            state_->update_range(begin, end, invalidate_from);
+            state->update_range(begin, end, invalidate_from);
         }
     }
 
     bool operator==(const life_observer &obs) const {
-        return this->state_ == obs.state_;
+        return state_.get() == obs.state_.get();
     }
     bool operator!=(const life_observer &obs) const {
-        return this->state_ != obs.state_;
+        return state_.get() != obs.state_.get();
+    }
+};
+
+/*!
+ * \brief 移動しない単一のオブジェクトのライフタイムを管理するクラス
+ *
+ * life と違い範囲を覚えておかず、 observer() の引数でオブジェクトを受け取る。
+ * イテレータのように値で渡される小さいクラスの中に置くためのもの。
+ *
+ */
+class object_life {
+    life_state_slot state_;
+
+  public:
+    object_life() = default;
+    object_life(const object_life &) = delete;
+    object_life &operator=(const object_life &) = delete;
+    ~object_life() = default;
+
+    /*!
+     * \param obj このobject_lifeを持っているオブジェクト
+     * (毎回同じものを渡すこと)
+     */
+    template <typename T>
+    life_observer observer(const T *obj) const {
+        return life_observer(
+            life_state_ref(state_.get_or_create(obj, obj + 1, nullptr)));
     }
 };
 } // namespace internal
@@ -0,0 +1,270 @@
+#pragma once
+#include "y3c/terminate.h"
+#include "y3c/algorithm.h"
+#include "y3c/iterator.h"
+#include "y3c/wrap.h"
+#include "y3c/typename.h"
+#include <numeric>
+
+namespace y3c {
+namespace internal {
+/*!
+ * \brief y3c/numeric の関数が受け付けるイテレータ
+ *
+ * contiguous_iterator (vector, array) と
+ * wrap<E*> (wrap<E[N]> から作ったポインタ) について特殊化し、
+ * 範囲をチェックして先頭の生ポインタを返す。
+ * それ以外の型では element_type が無いのでオーバーロードの候補から外れる。
+ *
+ */
+template <typename iterator>
+struct numeric_range {};
+template <typename T>
+struct numeric_range<contiguous_iterator<T>> {
+    using element_type = T;
+    static T *assert_range(const contiguous_iterator<T> &first,
+                           const contiguous_iterator<T> &last,
+                           const char *prefix, internal::skip_trace_tag = {}) {
+        return assert_algorithm_range(first, last, prefix);
+    }
+};
+template <typename T>
+struct numeric_range<wrap<T *>> {
+    using element_type = T;
+    static T *assert_range(const wrap<T *> &first, const wrap<T *> &last,
+                           const char *prefix, internal::skip_trace_tag = {}) {
+        func_name func(prefix, &get_type_name<wrap<T *>>, ")");
+        const life_observer &observer = first.get_observer_();
+        if (check_bounds && observer != last.get_observer_()) {
+            y3c::internal::terminate_ub_wrong_iter(func);
+        }
+        observer.assert_range_ptr(unwrap(first), unwrap(last), func);
+        return unwrap(first);
+    }
+};
+
+/*!
+ * \brief 要素を変換して畳み込む
+ *
+ * 計算順序が規定されていない transform_reduce 用。
+ * 4つの独立した累積値に分けることで依存関係を切り、ベクトル化しやすくする。
+ *
+ * \param transform インデックスを受け取り変換後の値を返す関数
+ *
+ */
+template <typename T, typename Reduce, typename Transform>
+T transform_reduce_raw(std::size_t n, T init, Reduce reduce,
+                       Transform transform) {
+    if (n < 4) {
+        for (std::size_t i = 0; i < n; i++) {
+            init = reduce(init, transform(i));
+        }
+        return init;
+    }
+    T acc0 = transform(0), acc1 = transform(1), acc2 = transform(2),
+      acc3 = transform(3);
+    std::size_t i = 4;
+    for (; i + 4 <= n; i += 4) {
+        acc0 = reduce(acc0, transform(i));
+        acc1 = reduce(acc1, transform(i + 1));
+        acc2 = reduce(acc2, transform(i + 2));
+        acc3 = reduce(acc3, transform(i + 3));
+    }
+    for (; i < n; i++) {
+        acc0 = reduce(acc0, transform(i));
+    }
+    return reduce(init, reduce(reduce(acc0, acc1), reduce(acc2, acc3)));
+}
+} // namespace internal
+
+/*!
+ * \brief 範囲の値を順に畳み込む (std::accumulate)
+ *
+ * * y3c:: のコンテナのイテレータ、または y3c::ptr の範囲を受け取る。
+ * * 範囲のチェックは最初に1回だけ行い、その後は生ポインタに対して計算する。
+ * * 範囲が無効な場合terminateする。
+ *
+ * \sa [accumulate -
+ * cpprefjp](https://cpprefjp.github.io/reference/numeric/accumulate.html)
+ */
+template <typename InputIt, typename T,
+          typename = typename internal::numeric_range<InputIt>::element_type,
+          typename = internal::skip_trace_tag>
+T accumulate(const InputIt &first, const InputIt &last, T init) {
+    auto begin = internal::numeric_range<InputIt>::assert_range(
+        first, last, "y3c::accumulate(");
+    return std::accumulate(begin, begin + (last - first), std::move(init));
+}
+/*!
+ * \brief 範囲の値を二項演算で順に畳み込む (std::accumulate)
+ */
+template <typename InputIt, typename T, typename BinaryOp,
+          typename = typename internal::numeric_range<InputIt>::element_type,
+          typename = internal::skip_trace_tag>
+T accumulate(const InputIt &first, const InputIt &last, T init, BinaryOp op) {
+    auto begin = internal::numeric_range<InputIt>::assert_range(
+        first, last, "y3c::accumulate(");
+    return std::accumulate(begin, begin + (last - first), std::move(init), op);
+}
+
+/*!
+ * \brief 2つの範囲の内積 (std::inner_product)
+ *
+ * * 2つ目の範囲も first2 から要素数分チェックする。
+ *
+ * \sa [inner_product -
+ * cpprefjp](https://cpprefjp.github.io/reference/numeric/inner_product.html)
+ */
+template <typename InputIt1, typename InputIt2, typename T,
+          typename = typename internal::numeric_range<InputIt1>::element_type,
+          typename = typename internal::numeric_range<InputIt2>::element_type,
+          typename = internal::skip_trace_tag>
+T inner_product(const InputIt1 &first1, const InputIt1 &last1,
+                const InputIt2 &first2, T init) {
+    auto begin1 = internal::numeric_range<InputIt1>::assert_range(
+        first1, last1, "y3c::inner_product(");
+    std::ptrdiff_t n = last1 - first1;
+    auto begin2 = internal::numeric_range<InputIt2>::assert_range(
+        first2, first2 + n, "y3c::inner_product(");
+    return std::inner_product(begin1, begin1 + n, begin2, std::move(init));
+}
+/*!
+ * \brief 2つの範囲の内積を任意の演算で計算する (std::inner_product)
+ */
+template <typename InputIt1, typename InputIt2, typename T, typename BinaryOp1,
+          typename BinaryOp2,
+          typename = typename internal::numeric_range<InputIt1>::element_type,
+          typename = typename internal::numeric_range<InputIt2>::element_type,
+          typename = internal::skip_trace_tag>
+T inner_product(const InputIt1 &first1, const InputIt1 &last1,
+                const InputIt2 &first2, T init, BinaryOp1 op1, BinaryOp2 op2) {
+    auto begin1 = internal::numeric_range<InputIt1>::assert_range(
+        first1, last1, "y3c::inner_product(");
+    std::ptrdiff_t n = last1 - first1;
+    auto begin2 = internal::numeric_range<InputIt2>::assert_range(
+        first2, first2 + n, "y3c::inner_product(");
+    return std::inner_product(begin1, begin1 + n, begin2, std::move(init),
+                              op1, op2);
+}
+
+/*!
+ * \brief 2つの範囲の要素の積の総和 (std::transform_reduce)
+ *
+ * * std::transform_reduce と同様計算順序は規定されない。
+ * (inner_product と違い浮動小数点数でもベクトル化できる)
+ * * C++11から使える。
+ *
+ * \sa [transform_reduce -
+ * cpprefjp](https://cpprefjp.github.io/reference/numeric/transform_reduce.html)
+ */
+template <typename InputIt1, typename InputIt2, typename T,
+          typename = typename internal::numeric_range<InputIt1>::element_type,
+          typename = typename internal::numeric_range<InputIt2>::element_type,
+          typename = internal::skip_trace_tag>
+T transform_reduce(const InputIt1 &first1, const InputIt1 &last1,
+                   const InputIt2 &first2, T init) {
+    auto begin1 = internal::numeric_range<InputIt1>::assert_range(
+        first1, last1, "y3c::transform_reduce(");
+    std::ptrdiff_t n = last1 - first1;
+    auto begin2 = internal::numeric_range<InputIt2>::assert_range(
+        first2, first2 + n, "y3c::transform_reduce(");
+    return internal::transform_reduce_raw(
+        static_cast<std::size_t>(n), std::move(init),
+        [](const T &a, const T &b) { return a + b; },
+        [&](std::size_t i) { return begin1[i] * begin2[i]; });
+}
+/*!
+ * \brief 2つの範囲を二項演算で変換して畳み込む (std::transform_reduce)
+ */
+template <typename InputIt1, typename InputIt2, typename T, typename Reduce,
+          typename Transform,
+          typename = typename internal::numeric_range<InputIt1>::element_type,
+          typename = typename internal::numeric_range<InputIt2>::element_type,
+          typename = internal::skip_trace_tag>
+T transform_reduce(const InputIt1 &first1, const InputIt1 &last1,
+                   const InputIt2 &first2, T init, Reduce reduce,
+                   Transform transform) {
+    auto begin1 = internal::numeric_range<InputIt1>::assert_range(
+        first1, last1, "y3c::transform_reduce(");
+    std::ptrdiff_t n = last1 - first1;
+    auto begin2 = internal::numeric_range<InputIt2>::assert_range(
+        first2, first2 + n, "y3c::transform_reduce(");
+    return internal::transform_reduce_raw(
+        static_cast<std::size_t>(n), std::move(init), reduce,
+        [&](std::size_t i) { return transform(begin1[i], begin2[i]); });
+}
+/*!
+ * \brief 範囲を単項演算で変換して畳み込む (std::transform_reduce)
+ */
+template <typename InputIt, typename T, typename Reduce, typename Transform,
+          typename = typename internal::numeric_range<InputIt>::element_type,
+          typename = internal::skip_trace_tag>
+T transform_reduce(const InputIt &first, const InputIt &last, T init,
+                   Reduce reduce, Transform transform) {
+    auto begin = internal::numeric_range<InputIt>::assert_range(
+        first, last, "y3c::transform_reduce(");
+    return internal::transform_reduce_raw(
+        static_cast<std::size_t>(last - first), std::move(init), reduce,
+        [&](std::size_t i) { return transform(begin[i]); });
+}
+
+/*!
+ * \brief 部分和を出力する (std::partial_sum)
+ *
+ * * 出力先も y3c:: のコンテナのイテレータまたは y3c::ptr で、
+ * 要素数分の範囲がない場合terminateする。
+ *
+ * \return 出力先の末尾
+ * \sa [partial_sum -
+ * cpprefjp](https://cpprefjp.github.io/reference/numeric/partial_sum.html)
+ */
+template <typename InputIt, typename OutputIt,
+          typename = typename internal::numeric_range<InputIt>::element_type,
+          typename = typename internal::numeric_range<OutputIt>::element_type,
+          typename = internal::skip_trace_tag>
+OutputIt partial_sum(const InputIt &first, const InputIt &last,
+                     const OutputIt &d_first) {
+    auto begin = internal::numeric_range<InputIt>::assert_range(
+        first, last, "y3c::partial_sum(");
+    std::ptrdiff_t n = last - first;
+    OutputIt d_last = d_first + n;
+    auto d_begin = internal::numeric_range<OutputIt>::assert_range(
+        d_first, d_last, "y3c::partial_sum(");
+    std::partial_sum(begin, begin + n, d_begin);
+    return d_last;
+}
+/*!
+ * \brief 二項演算で部分和を出力する (std::partial_sum)
+ */
+template <typename InputIt, typename OutputIt, typename BinaryOp,
+          typename = typename internal::numeric_range<InputIt>::element_type,
+          typename = typename internal::numeric_range<OutputIt>::element_type,
+          typename = internal::skip_trace_tag>
+OutputIt partial_sum(const InputIt &first, const InputIt &last,
+                     const OutputIt &d_first, BinaryOp op) {
+    auto begin = internal::numeric_range<InputIt>::assert_range(
+        first, last, "y3c::partial_sum(");
+    std::ptrdiff_t n = last - first;
+    OutputIt d_last = d_first + n;
+    auto d_begin = internal::numeric_range<OutputIt>::assert_range(
+        d_first, d_last, "y3c::partial_sum(");
+    std::partial_sum(begin, begin + n, d_begin, op);
+    return d_last;
+}
+
+/*!
+ * \brief 範囲を value から1ずつ増やした値で埋める (std::iota)
+ *
+ * \sa [iota -
+ * cpprefjp](https://cpprefjp.github.io/reference/numeric/iota.html)
+ */
+template <typename ForwardIt, typename T,
+          typename = typename internal::numeric_range<ForwardIt>::element_type,
+          typename = internal::skip_trace_tag>
+void iota(const ForwardIt &first, const ForwardIt &last, T value) {
+    auto begin = internal::numeric_range<ForwardIt>::assert_range(
+        first, last, "y3c::iota(");
+    std::iota(begin, begin + (last - first), std::move(value));
+}
+
+} // namespace y3c
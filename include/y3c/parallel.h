@@ -0,0 +1,409 @@
+#pragma once
+#include "y3c/terminate.h"
+#include "y3c/algorithm.h"
+#include "y3c/iterator.h"
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <numeric>
+#include <vector>
+#if !Y3C_SINGLE_THREADED
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace y3c {
+namespace internal {
+/*!
+ * \brief y3c::parallel の関数が使うスレッドプール
+ *
+ * 最初に使われたときに、環境変数 `Y3C_THREADS` で指定された数
+ * (無い場合はハードウェアのスレッド数) -1個のワーカーを起動する。
+ * run() は範囲を分割したチャンクの番号を共有のカウンタから1つずつ取り出して実行し、
+ * 呼び出したスレッド自身もワーカーと一緒にチャンクを処理する。
+ * (先に終わったスレッドが残りのチャンクを取りに行くので、
+ * チャンクごとの処理時間に偏りがあっても最後まで全スレッドが働く)
+ *
+ * * チャンクの中で投げられた例外は、最初の1つが run() の呼び出し元で再度投げられる。
+ * * run() の呼び出しは同時に1つずつ行う。
+ * チャンクの中から呼ばれた場合(ネストした場合)はその場で順に実行する。
+ * ワーカーだけでなく、チャンクを処理している呼び出し元のスレッドも同様。
+ * * Y3C_SINGLE_THREADED が有効な場合はワーカーを起動せず、常にその場で順に実行する。
+ *
+ */
+class thread_pool {
+#if !Y3C_SINGLE_THREADED
+    std::vector<std::thread> workers_;
+    std::mutex run_mutex_;
+    std::mutex mutex_;
+    std::condition_variable start_cv_, done_cv_;
+    const std::function<void(std::size_t)> *job_;
+    std::size_t job_chunks_;
+    std::atomic<std::size_t> next_chunk_;
+    std::size_t running_;
+    std::size_t generation_;
+    bool stop_;
+    std::exception_ptr error_;
+
+    static unsigned int default_threads() {
+        const char *env = std::getenv("Y3C_THREADS");
+        if (env) {
+            char *end;
+            unsigned long n = std::strtoul(env, &end, 10);
+            if (end != env && *end == '\0' && n > 0) {
+                return static_cast<unsigned int>(n);
+            }
+        }
+        return std::thread::hardware_concurrency();
+    }
+    /*!
+     * \brief このスレッドがチャンクを処理中かどうか
+     *
+     * ワーカーでは常にtrue、呼び出し元のスレッドでは run() の間だけtrue
+     *
+     */
+    static bool &in_run() {
+        static thread_local bool in_run = false;
+        return in_run;
+    }
+    struct in_run_guard {
+        in_run_guard() { in_run() = true; }
+        in_run_guard(const in_run_guard &) = delete;
+        in_run_guard &operator=(const in_run_guard &) = delete;
+        ~in_run_guard() { in_run() = false; }
+    };
+
+    /*!
+     * \brief チャンクが無くなるまで取り出して実行する
+     */
+    void work(const std::function<void(std::size_t)> &job,
+              std::size_t chunks) {
+        std::size_t i;
+        while ((i = next_chunk_.fetch_add(1, std::memory_order_relaxed)) <
+               chunks) {
+            try {
+                job(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!error_) {
+                    error_ = std::current_exception();
+                }
+            }
+        }
+    }
+    void worker_loop() {
+        in_run() = true;
+        std::size_t seen = 0;
+        while (true) {
+            const std::function<void(std::size_t)> *job;
+            std::size_t chunks;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                start_cv_.wait(lock,
+                               [&] { return stop_ || generation_ != seen; });
+                if (stop_) {
+                    return;
+                }
+                seen = generation_;
+                job = job_;
+                chunks = job_chunks_;
+            }
+            work(*job, chunks);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--running_ == 0) {
+                done_cv_.notify_one();
+            }
+        }
+    }
+
+  public:
+    thread_pool()
+        : workers_(), run_mutex_(), mutex_(), start_cv_(), done_cv_(),
+          job_(nullptr), job_chunks_(0), next_chunk_(0), running_(0),
+          generation_(0), stop_(false), error_() {
+        unsigned int n = default_threads();
+        for (unsigned int i = 1; i < n; i++) {
+            workers_.emplace_back([this] { worker_loop(); });
+        }
+    }
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        start_cv_.notify_all();
+        for (std::thread &t : workers_) {
+            t.join();
+        }
+    }
+
+    /*!
+     * \brief 呼び出し元のスレッドも含めたスレッド数
+     */
+    std::size_t size() const { return workers_.size() + 1; }
+
+    /*!
+     * \brief job(0) 〜 job(chunks - 1) を実行し、すべて終わるまで待つ
+     */
+    void run(std::size_t chunks, const std::function<void(std::size_t)> &job) {
+        if (chunks <= 1 || workers_.empty() || in_run()) {
+            for (std::size_t i = 0; i < chunks; i++) {
+                job(i);
+            }
+            return;
+        }
+        std::lock_guard<std::mutex> run_lock(run_mutex_);
+        in_run_guard guard;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = &job;
+            job_chunks_ = chunks;
+            next_chunk_.store(0, std::memory_order_relaxed);
+            running_ = workers_.size();
+            error_ = nullptr;
+            ++generation_;
+        }
+        start_cv_.notify_all();
+        work(job, chunks);
+        std::exception_ptr error;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_cv_.wait(lock, [&] { return running_ == 0; });
+            job_ = nullptr;
+            error = error_;
+            error_ = nullptr;
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+#else
+  public:
+    std::size_t size() const { return 1; }
+    void run(std::size_t chunks, const std::function<void(std::size_t)> &job) {
+        for (std::size_t i = 0; i < chunks; i++) {
+            job(i);
+        }
+    }
+#endif
+
+    static thread_pool &instance() {
+        static thread_pool pool;
+        return pool;
+    }
+};
+
+/*!
+ * \brief y3c::parallel の関数での範囲の分割
+ *
+ * 1チャンクあたり最低 min_chunk_size 要素とし、
+ * スレッド数の数倍まで分割する。
+ *
+ */
+struct parallel_chunks {
+    static constexpr std::size_t min_chunk_size = 2048;
+    std::size_t size, count;
+
+    parallel_chunks(std::size_t size, std::size_t max_count)
+        : size(size), count(size / min_chunk_size) {
+        if (count > max_count) {
+            count = max_count;
+        }
+        if (count == 0) {
+            count = 1;
+        }
+    }
+    std::size_t begin(std::size_t i) const { return size * i / count; }
+    std::size_t end(std::size_t i) const { return size * (i + 1) / count; }
+};
+
+/*!
+ * \brief 範囲をチャンクに分けて並列に処理する
+ *
+ * * 開始前に範囲全体を、各チャンクの開始時にそのチャンクの範囲をチェックする。
+ * * 全チャンクの終了後にもう一度範囲全体をチェックし、
+ * 処理中に元のコンテナが変更され範囲が無効になっていればterminateする。
+ *
+ * \param f 範囲の先頭へのポインタ、チャンクのインデックスの範囲、
+ * チャンク番号を受け取る
+ * \return 範囲の先頭へのポインタ
+ *
+ */
+template <typename T, typename F>
+T *parallel_for_chunks(const contiguous_iterator<T> &first,
+                       const contiguous_iterator<T> &last,
+                       const parallel_chunks &chunks, const char *prefix, F f,
+                       internal::skip_trace_tag = {}) {
+    T *begin = assert_algorithm_range(first, last, prefix);
+    thread_pool::instance().run(chunks.count, [&](std::size_t i) {
+        std::size_t b = chunks.begin(i), e = chunks.end(i);
+        assert_algorithm_range(first + static_cast<std::ptrdiff_t>(b),
+                               first + static_cast<std::ptrdiff_t>(e), prefix);
+        f(begin, b, e, i);
+    });
+    assert_algorithm_range(first, last, prefix);
+    return begin;
+}
+} // namespace internal
+
+/*!
+ * \brief 並列に実行する y3c/algorithm, y3c/numeric の関数
+ *
+ * y3c:: のコンテナのイテレータを受け取り、範囲を分割して
+ * 組み込みのスレッドプールで並列に実行する。
+ *
+ * * 範囲は開始前と各チャンクの開始時にチェックし、
+ * 終了後に元のコンテナが変更されていないかもチェックする。
+ * * 渡す関数は複数のスレッドから同時に呼ばれる。
+ * * Y3C_SINGLE_THREADED が有効な場合は呼び出し元のスレッドで順に実行する。
+ *
+ */
+namespace parallel {
+
+/*!
+ * \brief 範囲の各要素に関数を適用する (std::for_each)
+ *
+ * * f には要素の参照 (T&) が渡される。
+ *
+ * \sa [for_each -
+ * cpprefjp](https://cpprefjp.github.io/reference/algorithm/for_each.html)
+ */
+template <typename T, typename Function, typename = internal::skip_trace_tag>
+void for_each(const internal::contiguous_iterator<T> &first,
+              const internal::contiguous_iterator<T> &last, Function f) {
+    internal::parallel_chunks chunks(
+        static_cast<std::size_t>(last - first),
+        internal::thread_pool::instance().size() * 4);
+    internal::parallel_for_chunks(
+        first, last, chunks, "y3c::parallel::for_each(",
+        [&](T *begin, std::size_t b, std::size_t e, std::size_t) {
+            std::for_each(begin + b, begin + e, f);
+        });
+}
+
+/*!
+ * \brief 範囲の各要素を変換して出力する (std::transform)
+ *
+ * * 出力先に要素数分の範囲がない場合terminateする。
+ *
+ * \return 出力先の末尾のイテレータ
+ * \sa [transform -
+ * cpprefjp](https://cpprefjp.github.io/reference/algorithm/transform.html)
+ */
+template <typename T, typename U, typename UnaryOp,
+          typename = internal::skip_trace_tag>
+internal::contiguous_iterator<U>
+transform(const internal::contiguous_iterator<T> &first,
+          const internal::contiguous_iterator<T> &last,
+          const internal::contiguous_iterator<U> &d_first, UnaryOp op) {
+    std::ptrdiff_t n = last - first;
+    internal::contiguous_iterator<U> d_last = d_first + n;
+    U *d_begin = internal::assert_algorithm_range(
+        d_first, d_last, "y3c::parallel::transform(");
+    internal::parallel_chunks chunks(
+        static_cast<std::size_t>(n),
+        internal::thread_pool::instance().size() * 4);
+    internal::parallel_for_chunks(
+        first, last, chunks, "y3c::parallel::transform(",
+        [&](T *begin, std::size_t b, std::size_t e, std::size_t) {
+            std::transform(begin + b, begin + e, d_begin + b, op);
+        });
+    internal::assert_algorithm_range(d_first, d_last,
+                                     "y3c::parallel::transform(");
+    return d_last;
+}
+
+/*!
+ * \brief 範囲を比較関数で並列にソートする (std::sort)
+ *
+ * スレッド数のチャンクに分けてそれぞれソートした後、
+ * 隣り合うチャンクを std::inplace_merge で並列にマージしていく。
+ *
+ */
+template <typename T, typename Compare, typename = internal::skip_trace_tag>
+void sort(const internal::contiguous_iterator<T> &first,
+          const internal::contiguous_iterator<T> &last, Compare comp) {
+    internal::parallel_chunks chunks(static_cast<std::size_t>(last - first),
+                                     internal::thread_pool::instance().size());
+    T *data = internal::parallel_for_chunks(
+        first, last, chunks, "y3c::parallel::sort(",
+        [&](T *begin, std::size_t b, std::size_t e, std::size_t) {
+            std::sort(begin + b, begin + e, comp);
+        });
+    for (std::size_t width = 1; width < chunks.count; width *= 2) {
+        std::size_t merges = (chunks.count + 2 * width - 1) / (2 * width);
+        internal::thread_pool::instance().run(merges, [&](std::size_t m) {
+            std::size_t lo = 2 * width * m, mid = lo + width,
+                        hi = std::min(lo + 2 * width, chunks.count);
+            if (mid < hi) {
+                std::inplace_merge(data + chunks.begin(lo),
+                                   data + chunks.begin(mid),
+                                   data + chunks.end(hi - 1), comp);
+            }
+        });
+    }
+    internal::assert_algorithm_range(first, last, "y3c::parallel::sort(");
+}
+/*!
+ * \brief 範囲を並列にソートする (std::sort)
+ *
+ * * 範囲が無効な場合や、firstとlastが別のコンテナのイテレータの場合terminateする。
+ *
+ * \sa [sort -
+ * cpprefjp](https://cpprefjp.github.io/reference/algorithm/sort.html)
+ */
+template <typename T, typename = internal::skip_trace_tag>
+void sort(const internal::contiguous_iterator<T> &first,
+          const internal::contiguous_iterator<T> &last) {
+    y3c::parallel::sort(first, last, std::less<T>());
+}
+
+/*!
+ * \brief 範囲の値を二項演算で並列に畳み込む (std::reduce)
+ *
+ * * std::reduce と同様、 op は結合的である必要があり、計算順序は規定されない。
+ *
+ * \sa [reduce -
+ * cpprefjp](https://cpprefjp.github.io/reference/numeric/reduce.html)
+ */
+template <typename T, typename V, typename BinaryOp,
+          typename = internal::skip_trace_tag>
+V reduce(const internal::contiguous_iterator<T> &first,
+         const internal::contiguous_iterator<T> &last, V init, BinaryOp op) {
+    internal::parallel_chunks chunks(
+        static_cast<std::size_t>(last - first),
+        internal::thread_pool::instance().size() * 4);
+    // チャンクごとの結果。空の範囲の場合は使わない
+    std::vector<V> partial(chunks.count, init);
+    internal::parallel_for_chunks(
+        first, last, chunks, "y3c::parallel::reduce(",
+        [&](T *begin, std::size_t b, std::size_t e, std::size_t i) {
+            if (b < e) {
+                partial[i] = std::accumulate(begin + b + 1, begin + e,
+                                             V(begin[b]), op);
+            }
+        });
+    if (chunks.size == 0) {
+        return init;
+    }
+    for (const V &value : partial) {
+        init = op(init, value);
+    }
+    return init;
+}
+/*!
+ * \brief 範囲の値の総和を並列に計算する (std::reduce)
+ */
+template <typename T, typename V, typename = internal::skip_trace_tag>
+V reduce(const internal::contiguous_iterator<T> &first,
+         const internal::contiguous_iterator<T> &last, V init) {
+    return y3c::parallel::reduce(first, last, std::move(init), std::plus<V>());
+}
+
+} // namespace parallel
+} // namespace y3c
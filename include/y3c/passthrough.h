@@ -0,0 +1,60 @@
+#pragma once
+#ifdef Y3C_MESON
+#include "y3c-config.h"
+#else
+#include "y3c/y3c-config.h"
+#endif
+
+#if Y3C_PASSTHROUGH
+#include <utility>
+
+namespace y3c {
+/*!
+ * \brief パススルーモードの y3c::wrap
+ *
+ * Y3C_PASSTHROUGH が有効な場合、 y3c:: の各クラスは対応する std::
+ * のクラスや元の型の別名になり、チェックは一切行わない。
+ * `<y3c/vector>` などのヘッダーをそのまま使ったまま std:: と同じ速度で動かしたい場合に使う。
+ *
+ * * y3c::wrap<T> は T そのもの
+ * (`wrap<int&>` → `int&`, `wrap<int*>` → `int*`)
+ * * y3c::unwrap() は引数をそのまま返す。
+ * 引数が std:: の型になり y3c:: を付けずに呼ぶとADLで見つからなくなるので、
+ * グローバル名前空間にも unwrap() を置く。
+ *
+ */
+template <typename base_type>
+using wrap = base_type;
+
+template <typename element_type>
+using wrap_ref = element_type &;
+template <typename element_type>
+using const_wrap_ref = const element_type &;
+
+template <typename element_type>
+using ptr = element_type *;
+template <typename element_type>
+using const_ptr = const element_type *;
+template <typename element_type>
+using ptr_const = element_type *const;
+template <typename element_type>
+using const_ptr_const = const element_type *const;
+
+template <typename T>
+constexpr T &&unwrap(T &&value) noexcept {
+    return std::forward<T>(value);
+}
+
+/*!
+ * \brief パススルーモードの y3c::range() はコンテナをそのまま返す
+ */
+template <typename T>
+T &range(T &container) noexcept {
+    return container;
+}
+
+inline void link() {}
+} // namespace y3c
+
+using y3c::unwrap;
+#endif
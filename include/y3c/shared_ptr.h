@@ -30,7 +30,7 @@ class shared_ptr {
     std::shared_ptr<internal::life> ptr_life_;
     internal::life life_;
 
-    const std::string &type_name() const {
+    static const std::string &type_name() {
         return internal::get_type_name<shared_ptr>();
     }
 
@@ -184,8 +184,9 @@ class shared_ptr {
      */
     template <typename E = element_type, typename = internal::skip_trace_tag>
     y3c::wrap_ref<E> operator*() const {
-        if (!base_) {
-            static std::string func = type_name() + "::operator*()";
+        if (internal::check_nullptr && !base_) {
+            static constexpr internal::func_name func{&type_name,
+                                                      "::operator*()"};
             y3c::internal::terminate_ub_access_nullptr(func);
         }
         y3c_assert_internal(ptr_life_);
@@ -200,8 +201,9 @@ class shared_ptr {
      */
     template <typename = internal::skip_trace_tag>
     element_type *operator->() const {
-        if (!base_) {
-            static std::string func = type_name() + "::operator->()";
+        if (internal::check_nullptr && !base_) {
+            static constexpr internal::func_name func{&type_name,
+                                                      "::operator->()"};
             y3c::internal::terminate_ub_access_nullptr(func);
         }
         y3c_assert_internal(ptr_life_);
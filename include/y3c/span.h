@@ -0,0 +1,451 @@
+#pragma once
+#include "y3c/terminate.h"
+#include "y3c/wrap.h"
+#include "y3c/typename.h"
+#include "y3c/iterator.h"
+#include <type_traits>
+#include <utility>
+
+namespace y3c {
+
+/*!
+ * \brief y3c::span のサイズを指定しない場合の値 (std::dynamic_extent)
+ */
+constexpr std::size_t dynamic_extent = static_cast<std::size_t>(-1);
+
+template <typename T>
+class span;
+
+namespace internal {
+/*!
+ * \brief U の配列を T の配列として参照できるか (U → const U など)
+ */
+template <typename U, typename T>
+using span_convertible = std::is_convertible<U (*)[], T (*)[]>;
+
+/*!
+ * \brief data() が y3c::wrap<U*> を返すコンテナの要素型U
+ */
+template <typename Container>
+using span_container_element = typename std::remove_pointer<decltype(unwrap(
+    std::declval<Container &>().data()))>::type;
+
+template <typename T>
+struct is_span : std::false_type {};
+template <typename T>
+struct is_span<span<T>> : std::true_type {};
+
+template <typename T>
+class span_iterator;
+template <typename T>
+T *unwrap(const span_iterator<T> &wrapper) noexcept;
+
+/*!
+ * \brief y3c::span のイテレータ
+ *
+ * * 参照先のコンテナではなく、spanの範囲 [begin, end) で移動と要素アクセスをチェックする。
+ * * 要素アクセス時は span::operator[] と同様に、
+ * 参照先が生きていてその要素がまだ参照先の範囲内にあるかもチェックする。
+ * * spanと同様validatorは持たない。
+ * * y3c/algorithm の関数には渡せない (std:: のアルゴリズムは使える)。
+ *
+ */
+template <typename T>
+class span_iterator {
+    T *ptr_, *begin_, *end_;
+    life_observer observer_;
+
+    static const std::string &type_name() {
+        return get_type_name<span_iterator>();
+    }
+
+    template <typename = internal::skip_trace_tag>
+    T *assert_iter(std::ptrdiff_t n, const func_name &func) const {
+        std::ptrdiff_t index = (ptr_ - begin_) + n;
+        if (check_bounds && (index < 0 || index >= end_ - begin_)) {
+            y3c::internal::terminate_ub_out_of_range(
+                func, static_cast<std::size_t>(end_ - begin_), index);
+        }
+        return observer_.assert_ptr(ptr_ + n, func);
+    }
+    template <typename = internal::skip_trace_tag>
+    T *moved(std::ptrdiff_t n, const func_name &func) const {
+        std::ptrdiff_t index = (ptr_ - begin_) + n;
+        if (check_bounds && index > end_ - begin_) {
+            y3c::internal::terminate_ub_iter_after_end(func);
+        }
+        if (check_bounds && index < 0) {
+            y3c::internal::terminate_ub_iter_before_begin(func);
+        }
+        return ptr_ + n;
+    }
+
+  public:
+    span_iterator(T *ptr, T *begin, T *end, life_observer observer) noexcept
+        : ptr_(ptr), begin_(begin), end_(end), observer_(std::move(observer)) {
+    }
+    template <typename U, typename std::enable_if<
+                              std::is_same<const U, T>::value,
+                              std::nullptr_t>::type = nullptr>
+    span_iterator(const span_iterator<U> &other) noexcept
+        : ptr_(other.ptr_), begin_(other.begin_), end_(other.end_),
+          observer_(other.observer_) {}
+    span_iterator(const span_iterator &) = default;
+    span_iterator &operator=(const span_iterator &) = default;
+    ~span_iterator() = default;
+
+    template <typename U>
+    friend class span_iterator;
+    friend T *y3c::internal::unwrap<>(const span_iterator<T> &wrapper) noexcept;
+    const life_observer &get_observer_() const { return observer_; }
+
+    using difference_type = std::ptrdiff_t;
+    using value_type = typename std::remove_cv<T>::type;
+    using pointer = T *;
+    using reference = wrap_ref<T>;
+    using iterator_category = std::random_access_iterator_tag;
+
+    template <typename = internal::skip_trace_tag>
+    reference operator*() const {
+        static constexpr func_name func{&type_name, "::operator*()"};
+        return reference(assert_iter(0, func), observer_);
+    }
+    template <typename = internal::skip_trace_tag>
+    T *operator->() const {
+        static constexpr func_name func{&type_name, "::operator->()"};
+        return assert_iter(0, func);
+    }
+    template <typename = internal::skip_trace_tag>
+    reference operator[](std::ptrdiff_t n) const {
+        static constexpr func_name func{&type_name, "::operator[]()"};
+        return reference(assert_iter(n, func), observer_);
+    }
+
+    template <typename = internal::skip_trace_tag>
+    span_iterator &operator++() {
+        static constexpr func_name func{&type_name, "::operator++()"};
+        ptr_ = moved(1, func);
+        return *this;
+    }
+    template <typename = internal::skip_trace_tag>
+    span_iterator operator++(int) {
+        span_iterator copy = *this;
+        ++*this;
+        return copy;
+    }
+    template <typename = internal::skip_trace_tag>
+    span_iterator &operator--() {
+        static constexpr func_name func{&type_name, "::operator--()"};
+        ptr_ = moved(-1, func);
+        return *this;
+    }
+    template <typename = internal::skip_trace_tag>
+    span_iterator operator--(int) {
+        span_iterator copy = *this;
+        --*this;
+        return copy;
+    }
+    template <typename = internal::skip_trace_tag>
+    span_iterator &operator+=(std::ptrdiff_t n) {
+        static constexpr func_name func{&type_name, "::operator+=()"};
+        ptr_ = moved(n, func);
+        return *this;
+    }
+    template <typename = internal::skip_trace_tag>
+    span_iterator &operator-=(std::ptrdiff_t n) {
+        static constexpr func_name func{&type_name, "::operator-=()"};
+        ptr_ = moved(-n, func);
+        return *this;
+    }
+    template <typename = internal::skip_trace_tag>
+    span_iterator operator+(std::ptrdiff_t n) const {
+        static constexpr func_name func{&type_name, "::operator+()"};
+        return span_iterator(moved(n, func), begin_, end_, observer_);
+    }
+    template <typename = internal::skip_trace_tag>
+    span_iterator operator-(std::ptrdiff_t n) const {
+        static constexpr func_name func{&type_name, "::operator-()"};
+        return span_iterator(moved(-n, func), begin_, end_, observer_);
+    }
+    std::ptrdiff_t operator-(const span_iterator &other) const noexcept {
+        return ptr_ - other.ptr_;
+    }
+
+    bool operator==(const span_iterator &other) const noexcept {
+        return ptr_ == other.ptr_;
+    }
+    bool operator!=(const span_iterator &other) const noexcept {
+        return ptr_ != other.ptr_;
+    }
+    bool operator<(const span_iterator &other) const noexcept {
+        return ptr_ < other.ptr_;
+    }
+    bool operator>(const span_iterator &other) const noexcept {
+        return ptr_ > other.ptr_;
+    }
+    bool operator<=(const span_iterator &other) const noexcept {
+        return ptr_ <= other.ptr_;
+    }
+    bool operator>=(const span_iterator &other) const noexcept {
+        return ptr_ >= other.ptr_;
+    }
+};
+
+template <typename T>
+T *unwrap(const span_iterator<T> &wrapper) noexcept {
+    return wrapper.ptr_;
+}
+} // namespace internal
+
+/*!
+ * \brief 連続した要素の範囲を参照するビュー (std::span)
+ *
+ * * y3c::vector, y3c::array, y3c::wrap<E[N]>, y3c::wrap<T*> と要素数から作れる。
+ * * 参照先のコンテナのobserverをそのまま持ち、
+ * 作成時に範囲が参照先に収まっているかを1回だけチェックする。
+ * * subspan(), first(), last() はobserverをコピーするだけでチェックはしない。
+ * * 要素アクセス時は、インデックスがspanの範囲内かと、
+ * 参照先が生きていてその要素がまだ参照先の範囲内にあるかをチェックする
+ * (イテレータと違いvalidatorは持たないので、世代の比較も不要)。
+ * * イテレータ (internal::span_iterator) もspan自身の範囲で移動と要素アクセスをチェックする。
+ * * std::span と違いサイズを型に含めることはできない (常に dynamic_extent)。
+ *
+ * \sa [span - cpprefjp](https://cpprefjp.github.io/reference/span/span.html)
+ */
+template <typename T>
+class span {
+    T *ptr_;
+    std::size_t size_;
+    internal::life_observer observer_;
+
+    static const std::string &type_name() {
+        return internal::get_type_name<span>();
+    }
+
+    struct unchecked_tag {};
+    span(T *ptr, std::size_t size, internal::life_observer observer,
+         unchecked_tag) noexcept
+        : ptr_(ptr), size_(size), observer_(std::move(observer)) {}
+
+    template <typename = internal::skip_trace_tag>
+    void assert_subspan(std::size_t offset, std::size_t count,
+                        const internal::func_name &func) const {
+        if (internal::check_bounds &&
+            (offset > size_ || count > size_ - offset)) {
+            y3c::internal::terminate_ub_out_of_range(
+                func, size_, static_cast<std::ptrdiff_t>(offset),
+                static_cast<std::ptrdiff_t>(offset + count));
+        }
+    }
+
+  public:
+    using element_type = T;
+    using value_type = typename std::remove_cv<T>::type;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = wrap<T *>;
+    using const_pointer = wrap<const T *>;
+    using reference = wrap_ref<T>;
+    using const_reference = const_wrap_ref<T>;
+    using iterator = internal::span_iterator<T>;
+
+    template <typename>
+    friend class span;
+
+    /*!
+     * \brief 空のspan
+     */
+    span() noexcept : ptr_(nullptr), size_(0), observer_(nullptr) {}
+    /*!
+     * \brief ポインタと要素数から作成
+     *
+     * * [first, first + count) が参照先の範囲外の場合terminateする。
+     *
+     */
+    template <typename = internal::skip_trace_tag>
+    span(const wrap<T *> &first, size_type count)
+        : ptr_(unwrap(first)), size_(count),
+          observer_(first.get_observer_()) {
+        if (count > 0) {
+            static constexpr internal::func_name func{&type_name, "::span()"};
+            observer_.assert_range_ptr(ptr_, ptr_ + count, func);
+        }
+    }
+    /*!
+     * \brief 配列型wrapの全体を参照する
+     */
+    template <typename U, std::size_t N,
+              typename std::enable_if<internal::span_convertible<U, T>::value,
+                                      std::nullptr_t>::type = nullptr>
+    span(wrap<U[N]> &array) : span(wrap<T *>(wrap<U *>(array)), N) {}
+    /*!
+     * \brief 配列型wrapの全体を参照する(const)
+     */
+    template <typename U, std::size_t N,
+              typename std::enable_if<
+                  internal::span_convertible<const U, T>::value,
+                  std::nullptr_t>::type = nullptr>
+    span(const wrap<U[N]> &array)
+        : span(wrap<T *>(wrap<const U *>(array)), N) {}
+    /*!
+     * \brief y3c::vector, y3c::array などのコンテナの全体を参照する
+     *
+     * data() と size() を使う。
+     * 一時オブジェクトからは作れない。
+     *
+     */
+    template <typename Container,
+              typename U = internal::span_container_element<Container>,
+              typename std::enable_if<
+                  !internal::is_span<
+                      typename std::remove_const<Container>::type>::value &&
+                      internal::span_convertible<U, T>::value,
+                  std::nullptr_t>::type = nullptr>
+    span(Container &c) : span(wrap<T *>(c.data()), c.size()) {}
+    /*!
+     * \brief 別の要素型のspanからの変換 (span<T> → span<const T>)
+     */
+    template <typename U,
+              typename std::enable_if<internal::span_convertible<U, T>::value,
+                                      std::nullptr_t>::type = nullptr>
+    span(const span<U> &other) noexcept
+        : ptr_(other.ptr_), size_(other.size_), observer_(other.observer_) {}
+
+    span(const span &) = default;
+    span &operator=(const span &) = default;
+    ~span() = default;
+
+    size_type size() const noexcept { return size_; }
+    size_type size_bytes() const noexcept { return size_ * sizeof(T); }
+    bool empty() const noexcept { return size_ == 0; }
+
+    /*!
+     * \brief 要素アクセス
+     *
+     * * インデックスが範囲外の場合、
+     * または参照先が破棄されたか縮んで要素が範囲外になった場合terminateする。
+     *
+     */
+    template <typename = internal::skip_trace_tag>
+    reference operator[](size_type n) const {
+        static constexpr internal::func_name func{&type_name,
+                                                  "::operator[]()"};
+        if (internal::check_bounds && n >= size_) {
+            y3c::internal::terminate_ub_out_of_range(
+                func, size_, static_cast<std::ptrdiff_t>(n));
+        }
+        return reference(observer_.assert_ptr(ptr_ + n, func), observer_);
+    }
+    /*!
+     * \brief 先頭の要素へのアクセス
+     *
+     * * サイズが0の場合terminateする。
+     *
+     */
+    template <typename = internal::skip_trace_tag>
+    reference front() const {
+        static constexpr internal::func_name func{&type_name, "::front()"};
+        if (internal::check_bounds && size_ == 0) {
+            y3c::internal::terminate_ub_out_of_range(func, size_, 0);
+        }
+        return reference(observer_.assert_ptr(ptr_, func), observer_);
+    }
+    /*!
+     * \brief 末尾の要素へのアクセス
+     *
+     * * サイズが0の場合terminateする。
+     *
+     */
+    template <typename = internal::skip_trace_tag>
+    reference back() const {
+        static constexpr internal::func_name func{&type_name, "::back()"};
+        if (internal::check_bounds && size_ == 0) {
+            y3c::internal::terminate_ub_out_of_range(func, size_, -1);
+        }
+        return reference(observer_.assert_ptr(ptr_ + size_ - 1, func),
+                         observer_);
+    }
+    /*!
+     * \brief 先頭へのポインタ
+     */
+    pointer data() const { return pointer(ptr_, observer_); }
+
+    iterator begin() const {
+        return iterator(ptr_, ptr_, ptr_ + size_, observer_);
+    }
+    iterator end() const {
+        return iterator(ptr_ + size_, ptr_, ptr_ + size_, observer_);
+    }
+
+    /*!
+     * \brief 先頭からcount個の要素を参照するspan
+     *
+     * * countがサイズより大きい場合terminateする。
+     *
+     */
+    template <typename = internal::skip_trace_tag>
+    span first(size_type count) const {
+        static constexpr internal::func_name func{&type_name, "::first()"};
+        assert_subspan(0, count, func);
+        return span(ptr_, count, observer_, unchecked_tag());
+    }
+    /*!
+     * \brief 末尾からcount個の要素を参照するspan
+     *
+     * * countがサイズより大きい場合terminateする。
+     *
+     */
+    template <typename = internal::skip_trace_tag>
+    span last(size_type count) const {
+        static constexpr internal::func_name func{&type_name, "::last()"};
+        assert_subspan(0, count, func);
+        return span(ptr_ + (size_ - count), count, observer_, unchecked_tag());
+    }
+    /*!
+     * \brief offset番目からcount個の要素を参照するspan
+     *
+     * * countが dynamic_extent の場合は末尾まで。
+     * * 範囲がこのspanに収まらない場合terminateする。
+     *
+     */
+    template <typename = internal::skip_trace_tag>
+    span subspan(size_type offset, size_type count = dynamic_extent) const {
+        static constexpr internal::func_name func{&type_name, "::subspan()"};
+        if (count == dynamic_extent) {
+            assert_subspan(offset, 0, func);
+            count = size_ - offset;
+        }
+        assert_subspan(offset, count, func);
+        return span(ptr_ + offset, count, observer_, unchecked_tag());
+    }
+
+    /*!
+     * \brief y3c::range() から呼ばれる
+     */
+    internal::contiguous_range<T> get_range_() const {
+        static constexpr internal::func_name func{"y3c::range(", &type_name,
+                                                  ")"};
+        return internal::contiguous_range<T>(ptr_, ptr_ + size_, observer_,
+                                             func);
+    }
+};
+
+/*!
+ * \brief 範囲のチェックをループの開始時に1回だけ行う range-for 用の範囲
+ *
+ * `for (auto &x : y3c::range(s))` のように使う。
+ *
+ * * spanはビューなので一時オブジェクトも渡せる。
+ *
+ */
+template <typename T>
+internal::contiguous_range<T> range(const span<T> &s) {
+    return s.get_range_();
+}
+
+template <typename T>
+T *unwrap(const internal::span_iterator<T> &wrapper) noexcept {
+    return internal::unwrap(wrapper);
+}
+
+} // namespace y3c
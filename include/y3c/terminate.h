@@ -11,6 +11,23 @@
 #include <unordered_map>
 #include <atomic>
 
+/*!
+ * \brief terminateや例外を投げる処理に付ける属性
+ *
+ * 呼び出し元にインライン展開されないようにし、
+ * チェックする側の関数が比較と分岐だけの小さいコードになるようにする。
+ *
+ * (dll境界を越えて例外を投げないよう、ヘッダー内の関数であることは変えない)
+ *
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define Y3C_COLD __attribute__((noinline, cold))
+#elif defined(_MSC_VER)
+#define Y3C_COLD __declspec(noinline)
+#else
+#define Y3C_COLD
+#endif
+
 namespace y3c {
 namespace internal {
 
@@ -26,6 +43,108 @@ Y3C_DLL void Y3C_CALL link() noexcept;
  */
 struct skip_trace_tag {};
 
+/*!
+ * \brief エラーメッセージに表示する関数名
+ *
+ * `prefix + type_name() + suffix` を表すが、
+ * 文字列を作るのは実際にterminateするときだけにする。
+ * 各関数の中で `static constexpr func_name func{...}` のように定義して使う。
+ *
+ */
+struct func_name {
+    using type_name_func = const std::string &(*)();
+    /*!
+     * \brief 型名をオブジェクト (context) から取得する関数
+     *
+     * イテレータの型名のように実行時にしか分からないものに使う。
+     * 呼ばれるのは str() のときだけなので、
+     * チェックが成功する場合は context に一切触れない。
+     *
+     */
+    using type_name_of_func = const std::string &(*)(const void *context);
+
+    const char *prefix;
+    type_name_func type_name;
+    const char *suffix;
+    type_name_of_func type_name_of;
+    const void *context;
+
+    constexpr func_name(type_name_func type_name, const char *suffix) noexcept
+        : prefix(""), type_name(type_name), suffix(suffix),
+          type_name_of(nullptr), context(nullptr) {}
+    constexpr func_name(const char *prefix, type_name_func type_name,
+                        const char *suffix) noexcept
+        : prefix(prefix), type_name(type_name), suffix(suffix),
+          type_name_of(nullptr), context(nullptr) {}
+    /*!
+     * \param context str() が呼ばれるまで生きている必要がある
+     */
+    constexpr func_name(const char *prefix, type_name_of_func type_name_of,
+                        const void *context, const char *suffix) noexcept
+        : prefix(prefix), type_name(nullptr), suffix(suffix),
+          type_name_of(type_name_of), context(context) {}
+
+    std::string str() const {
+        return prefix + (type_name ? type_name() : type_name_of(context)) +
+               suffix;
+    }
+};
+
+/*!
+ * \brief Y3C_CHECK_LEVEL で有効になっているチェック
+ *
+ * `if (check_bounds && ...)` のように使えば無効な場合は最適化で消える。
+ *
+ * * check_bounds: 範囲外アクセス、範囲外へのイテレータの移動、
+ * 別のコンテナのイテレータの使用
+ * * check_lifetime: 寿命が切れた値へのアクセス、無効になったイテレータの使用
+ * * check_nullptr: nullptrアクセス (どちらかが有効な場合)
+ *
+ * at() が投げる例外のように、std::でも定義されている動作はチェックレベルによらず変わらない。
+ *
+ */
+constexpr bool check_bounds = (Y3C_CHECK_LEVEL & Y3C_CHECK_BOUNDS) != 0;
+constexpr bool check_lifetime = (Y3C_CHECK_LEVEL & Y3C_CHECK_LIFETIME) != 0;
+constexpr bool check_nullptr = check_bounds || check_lifetime;
+
+/*!
+ * \brief サンプリングモードでのチェックの間隔
+ *
+ * Nの場合、 life_observer::assert_iter() などの検証をN回に1回だけ行う。
+ * (1以下なら毎回行う)
+ * 起動時に環境変数 `Y3C_SAMPLE` から読み込まれる。
+ *
+ */
+extern Y3C_DLL std::atomic<std::size_t> check_sample_interval;
+
+/*!
+ * \brief 今回の検証を行うかどうか
+ *
+ * 呼び出し回数はスレッドごとに数える。
+ * チェックがすべて無効なレベルでは常にfalseで、カウンタにも触れない。
+ *
+ */
+inline bool check_sampled() {
+    if (!check_nullptr) {
+        return false;
+    }
+    std::size_t interval =
+        check_sample_interval.load(std::memory_order_relaxed);
+    if (interval <= 1) {
+        return true;
+    }
+#if Y3C_SINGLE_THREADED
+    static std::size_t count = 0;
+#else
+    static thread_local std::size_t count = 0;
+#endif
+    if (++count < interval) {
+        return false;
+    }
+    count = 0;
+    return true;
+}
+
 enum class terminate_type {
     exception,
     terminate,
@@ -37,6 +156,7 @@ enum class terminate_type {
     ub_invalid_iter,
     ub_iter_after_end,
     ub_iter_before_begin,
+    ub_modify_pinned,
 };
 
 struct terminate_detail {
@@ -121,12 +241,25 @@ extern Y3C_DLL bool throw_on_terminate;
         const char *what() const noexcept override { return #ub_name; }        \
     };                                                                         \
     template <typename... Args, typename = skip_trace_tag>                     \
-    [[noreturn]] void terminate_##ub_name(std::string func, Args &&...args) {  \
+    [[noreturn]] Y3C_COLD void terminate_##ub_name(std::string func,           \
+                                                   Args &&...args) {           \
         if (throw_on_terminate) {                                              \
             throw ub_name();                                                   \
         }                                                                      \
         do_terminate_with({terminate_type::ub_name, std::move(func),           \
                            what::ub_name(std::forward<Args>(args)...)});       \
+    }                                                                          \
+    template <typename... Args, typename = skip_trace_tag>                     \
+    [[noreturn]] Y3C_COLD void terminate_##ub_name(const func_name &func,      \
+                                                   Args &&...args) {           \
+        terminate_##ub_name(func.str(), std::forward<Args>(args)...);          \
+    }                                                                          \
+    /* デストラクタ用 (throw_on_terminate でも投げずに強制終了する) */         \
+    template <typename... Args, typename = skip_trace_tag>                     \
+    [[noreturn]] Y3C_COLD void terminate_##ub_name##_noexcept(                 \
+        const func_name &func, Args &&...args) noexcept {                      \
+        do_terminate_with({terminate_type::ub_name, func.str(),                \
+                           what::ub_name(std::forward<Args>(args)...)});       \
     }
 
 define_terminate_func(ub_out_of_range);
@@ -136,11 +269,12 @@ define_terminate_func(ub_wrong_iter);
 define_terminate_func(ub_invalid_iter);
 define_terminate_func(ub_iter_after_end);
 define_terminate_func(ub_iter_before_begin);
+define_terminate_func(ub_modify_pinned);
 
 #undef define_terminate_func
 
-[[noreturn]] inline void terminate_internal(std::string func, std::string what,
-                                            skip_trace_tag = {}) {
+[[noreturn]] Y3C_COLD inline void
+terminate_internal(std::string func, std::string what, skip_trace_tag = {}) {
     do_terminate_with(
         {terminate_type::internal, std::move(func), std::move(what)});
 }
@@ -190,4 +324,19 @@ class out_of_range final : public std::out_of_range,
     }
 };
 
+namespace internal {
+/*!
+ * \brief y3c::out_of_range を投げる
+ *
+ * at() などから呼ぶ。文字列の組み立てを呼び出し元に展開させないため別の関数にしている
+ *
+ */
+template <typename = skip_trace_tag>
+[[noreturn]] Y3C_COLD void throw_out_of_range(const func_name &func,
+                                              std::size_t size,
+                                              std::ptrdiff_t index) {
+    throw y3c::out_of_range(func.str(), size, index);
+}
+} // namespace internal
+
 } // namespace y3c
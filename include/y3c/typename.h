@@ -1,7 +1,15 @@
 #pragma once
 #include "y3c/terminate.h"
+#include <cctype>
 #include <string>
 
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#define Y3C_CONSTEXPR_TYPE_NAME 1
+#include <string_view>
+#else
+#define Y3C_CONSTEXPR_TYPE_NAME 0
+#endif
+
 // based on
 // https://stackoverflow.com/questions/81870/is-it-possible-to-print-a-variables-type-in-standard-c/58331141#58331141
 
@@ -18,35 +26,113 @@ const char *wrapped_type_name() {
     return __func__;
 #endif
 }
-template <typename T>
-const std::string &wrapped_type_name_s() {
-    static const std::string name = wrapped_type_name<T>();
-    return name;
-}
 
 class probe_type;
-const char *const probe_type_name_candidates[] = {
+constexpr const char *probe_type_name_candidates[] = {
     "class y3c::internal::type_name::probe_type",
     "y3c::internal::type_name::probe_type",
     "probe_type",
 };
-inline const std::string &probe_type_name_used() {
-    static std::string name;
-    if (name.empty()) {
-        for (const char *probe_type_name : probe_type_name_candidates) {
-            if (wrapped_type_name_s<probe_type>().find(probe_type_name) !=
-                std::string::npos) {
-                name = probe_type_name;
-                break;
-            }
+
+#if Y3C_CONSTEXPR_TYPE_NAME
+/*
+ * C++17以降: シグネチャの解析をすべてコンパイル時に行う
+ */
+template <typename T>
+constexpr std::string_view wrapped_type_name_view() {
+#if defined(__clang__) || defined(__GNUC__)
+    return __PRETTY_FUNCTION__;
+#elif defined(_MSC_VER)
+    return __FUNCSIG__;
+#else
+    return __func__;
+#endif
+}
+
+constexpr std::string_view probe_type_name_used() {
+    for (const char *probe_type_name : probe_type_name_candidates) {
+        if (wrapped_type_name_view<probe_type>().find(probe_type_name) !=
+            std::string_view::npos) {
+            return probe_type_name;
         }
-        if (name.empty()) {
-            internal::terminate_internal(
-                "y3c::internal::type_name::probe_type_name_used()",
-                "probe_type_name not found from signature: " +
-                    wrapped_type_name_s<probe_type>());
+    }
+    return std::string_view();
+}
+static_assert(!probe_type_name_used().empty(),
+              "probe_type_name not found from signature");
+
+constexpr std::size_t prefix_size() {
+    return wrapped_type_name_view<probe_type>().find(probe_type_name_used());
+}
+constexpr std::size_t suffix_size() {
+    return wrapped_type_name_view<probe_type>().length() - prefix_size() -
+           probe_type_name_used().length();
+}
+
+constexpr bool is_ident_char(char c) {
+    return ('0' <= c && c <= '9') || ('a' <= c && c <= 'z') ||
+           ('A' <= c && c <= 'Z') || c == '_';
+}
+template <std::size_t N>
+struct fixed_name {
+    char data[N + 1];
+    std::size_t size;
+};
+/*!
+ * \brief "class ", "struct " を取り除いてコピーする
+ */
+template <std::size_t N>
+constexpr fixed_name<N> strip_keywords(std::string_view name) {
+    fixed_name<N> out{};
+    std::size_t o = 0;
+    for (std::size_t i = 0; i < name.size();) {
+        bool boundary = i == 0 || !is_ident_char(name[i - 1]);
+        if (boundary && name.substr(i, 6) == "class ") {
+            i += 6;
+        } else if (boundary && name.substr(i, 7) == "struct ") {
+            i += 7;
+        } else {
+            out.data[o++] = name[i++];
+        }
+    }
+    out.data[o] = '\0';
+    out.size = o;
+    return out;
+}
+
+template <typename T>
+struct constexpr_type_name {
+    static constexpr std::string_view wrapped = wrapped_type_name_view<T>();
+    static constexpr std::string_view raw = wrapped.substr(
+        prefix_size(), wrapped.length() - prefix_size() - suffix_size());
+    static constexpr fixed_name<raw.size()> value =
+        strip_keywords<raw.size()>(raw);
+};
+
+#else
+/*
+ * C++11, 14: 初回の呼び出し時に実行時に解析する
+ */
+template <typename T>
+const std::string &wrapped_type_name_s() {
+    static const std::string name = wrapped_type_name<T>();
+    return name;
+}
+
+inline std::string find_probe_type_name() {
+    for (const char *probe_type_name : probe_type_name_candidates) {
+        if (wrapped_type_name_s<probe_type>().find(probe_type_name) !=
+            std::string::npos) {
+            return probe_type_name;
         }
     }
+    internal::terminate_internal(
+        "y3c::internal::type_name::probe_type_name_used()",
+        "probe_type_name not found from signature: " +
+            wrapped_type_name_s<probe_type>());
+}
+inline const std::string &probe_type_name_used() {
+    static const std::string name = find_probe_type_name();
     return name;
 }
 
@@ -57,32 +143,57 @@ inline size_t suffix_size() {
     return wrapped_type_name_s<probe_type>().length() - prefix_size() -
            probe_type_name_used().length();
 }
-} // namespace type_name
 
-template <typename T>
-const std::string &get_type_name() {
-    static std::string name;
-    if (name.empty()) {
-        const std::string &t_name = type_name::wrapped_type_name_s<T>();
-        y3c_assert_internal(t_name.length() > type_name::prefix_size() +
-                                                  type_name::suffix_size());
-        name = t_name.substr(type_name::prefix_size(),
-                             t_name.length() - type_name::prefix_size() -
-                                 type_name::suffix_size());
-        for (std::size_t i = 0;
-             (i = name.find("class ", i)) != std::string::npos; i++) {
-            if (i == 0 || (!std::isalnum(name[i - 1]) && name[i - 1] != '_')) {
-                name = name.replace(i, 6, "");
-            }
+inline std::string parse_type_name(const std::string &t_name) {
+    y3c_assert_internal(t_name.length() > type_name::prefix_size() +
+                                              type_name::suffix_size());
+    std::string name = t_name.substr(type_name::prefix_size(),
+                                     t_name.length() - type_name::prefix_size() -
+                                         type_name::suffix_size());
+    for (std::size_t i = 0; (i = name.find("class ", i)) != std::string::npos;
+         i++) {
+        if (i == 0 || (!std::isalnum(name[i - 1]) && name[i - 1] != '_')) {
+            name = name.replace(i, 6, "");
         }
-        for (std::size_t i = 0;
-             (i = name.find("struct ", i)) != std::string::npos; i++) {
-            if (i == 0 || (!std::isalnum(name[i - 1]) && name[i - 1] != '_')) {
-                name = name.replace(i, 7, "");
-            }
+    }
+    for (std::size_t i = 0; (i = name.find("struct ", i)) != std::string::npos;
+         i++) {
+        if (i == 0 || (!std::isalnum(name[i - 1]) && name[i - 1] != '_')) {
+            name = name.replace(i, 7, "");
         }
     }
     return name;
 }
+#endif
+} // namespace type_name
+
+#if Y3C_CONSTEXPR_TYPE_NAME
+/*!
+ * \brief 型名をコンパイル時に取得する (C++17以降)
+ */
+template <typename T>
+constexpr std::string_view get_type_name_view() {
+    return std::string_view(type_name::constexpr_type_name<T>::value.data,
+                            type_name::constexpr_type_name<T>::value.size);
+}
+#endif
+
+/*!
+ * \brief 型名を取得する
+ *
+ * C++17以降ではコンパイル時に求めた文字列をコピーするだけ。
+ * いずれの場合も初期化はスレッドセーフ。
+ *
+ */
+template <typename T>
+const std::string &get_type_name() {
+#if Y3C_CONSTEXPR_TYPE_NAME
+    static const std::string name(get_type_name_view<T>());
+#else
+    static const std::string name =
+        type_name::parse_type_name(type_name::wrapped_type_name_s<T>());
+#endif
+    return name;
+}
 } // namespace internal
 } // namespace y3c
@@ -4,9 +4,95 @@
 #include "y3c/typename.h"
 #include "y3c/iterator.h"
 #include <vector>
+#include <algorithm>
+#include <iterator>
 #include <memory>
+#include <type_traits>
 
 namespace y3c {
+namespace internal {
+struct range_priority_low {};
+struct range_priority_high : range_priority_low {};
+
+/*!
+ * \brief append_range() などに渡された範囲の先頭
+ *
+ * y3c::vector, y3c::array など unwrap() できるものは
+ * std:: のコンテナに戻してから走査し、要素ごとのチェックを省く。
+ * それ以外は std::begin() をそのまま使う。
+ *
+ */
+template <typename R>
+auto bulk_range_begin(R &rg, range_priority_high)
+    -> decltype(std::begin(unwrap(rg))) {
+    return std::begin(unwrap(rg));
+}
+template <typename R>
+auto bulk_range_begin(R &rg, range_priority_low) -> decltype(std::begin(rg)) {
+    return std::begin(rg);
+}
+/*!
+ * \brief append_range() などに渡された範囲の末尾
+ */
+template <typename R>
+auto bulk_range_end(R &rg, range_priority_high)
+    -> decltype(std::end(unwrap(rg))) {
+    return std::end(unwrap(rg));
+}
+template <typename R>
+auto bulk_range_end(R &rg, range_priority_low) -> decltype(std::end(rg)) {
+    return std::end(rg);
+}
+/*!
+ * \brief append_range() などに渡された範囲が右辺値の場合、
+ * 要素をムーブするイテレータにする
+ *
+ * \tparam R append_range() などの引数の型 (R&& で受け取ったもの)
+ *
+ */
+template <typename R, typename It>
+auto bulk_range_forward(It it) -> typename std::conditional<
+    std::is_lvalue_reference<R>::value, It, std::move_iterator<It>>::type {
+    return typename std::conditional<std::is_lvalue_reference<R>::value, It,
+                                     std::move_iterator<It>>::type(it);
+}
+
+/*!
+ * \brief vector::pin() で作られた有効な pinned の数
+ *
+ * constなvectorを複数のスレッドから同時に pin() できるようにatomicにする。
+ * Y3C_SINGLE_THREADED が有効な場合はatomicでない整数を使う。
+ *
+ */
+class pin_count {
+#if Y3C_SINGLE_THREADED
+    std::size_t count_;
+#else
+    std::atomic<std::size_t> count_;
+#endif
+
+  public:
+    pin_count() noexcept : count_(0) {}
+    pin_count(const pin_count &) = delete;
+    pin_count &operator=(const pin_count &) = delete;
+
+#if Y3C_SINGLE_THREADED
+    void increment() noexcept { ++count_; }
+    void decrement() noexcept { --count_; }
+    bool pinned() const noexcept { return count_ != 0; }
+#else
+    void increment() noexcept {
+        count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    void decrement() noexcept {
+        count_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    bool pinned() const noexcept {
+        return count_.load(std::memory_order_relaxed) != 0;
+    }
+#endif
+};
+} // namespace internal
 
 /*!
  * \brief 可変長配列 (std::vector)
@@ -21,20 +107,35 @@ namespace y3c {
  */
 template <typename T>
 class vector {
+  public:
+    class transaction;
+
+  private:
     std::vector<T> base_;
-    std::unique_ptr<internal::life> elems_life_;
+    /*!
+     * 要素のライフタイム。
+     * life_state は最初にイテレータなどを作るまで確保されないので、
+     * それまではヒープを使わない
+     */
+    internal::life elems_life_{nullptr, nullptr, &iter_name};
     internal::life life_;
+    /*!
+     * 有効な pin() の数
+     */
+    mutable internal::pin_count pins_;
 
     /*!
      * \brief ライフタイムを初期化
+     *
+     * 以前の要素を指していたイテレータなどは無効になる
+     *
      */
     void init_elems_life() {
         if (!base_.empty()) {
-            elems_life_ = std::unique_ptr<internal::life>(
-                new internal::life(&base_[0], &base_[0] + base_.size()));
+            elems_life_ = internal::life(&base_[0], &base_[0] + base_.size(),
+                                         &iter_name);
         } else {
-            elems_life_ = std::unique_ptr<internal::life>(
-                new internal::life(nullptr, nullptr));
+            elems_life_ = internal::life(nullptr, nullptr, &iter_name);
         }
     }
     /*!
@@ -44,26 +145,51 @@ class vector {
      */
     void update_elems_life(const void *invalidate_from = nullptr) {
         if (!base_.empty()) {
-            elems_life_->update(&base_[0], &base_[0] + base_.size(),
+            elems_life_.update(&base_[0], &base_[0] + base_.size(),
                                 invalidate_from);
         } else {
-            elems_life_->update(nullptr, nullptr);
+            elems_life_.update(nullptr, nullptr);
         }
     }
 
-    const std::string &type_name() const {
+    /*!
+     * \brief pin() されていないことをチェックする
+     *
+     * 要素数や領域を変更する関数の最初に呼ぶ。
+     * 無効化の記録をたどらずカウンタの比較だけで済む。
+     *
+     */
+    void assert_not_pinned(const internal::func_name &func,
+                           internal::skip_trace_tag = {}) const {
+        if (internal::check_lifetime && pins_.pinned()) {
+            y3c::internal::terminate_ub_modify_pinned(func);
+        }
+    }
+    /*!
+     * \brief ムーブ元として要素を渡す
+     */
+    std::vector<T> &&take_base_(const internal::func_name &func,
+                                internal::skip_trace_tag = {}) {
+        assert_not_pinned(func);
+        return std::move(base_);
+    }
+    std::vector<T> &&take_base_(internal::skip_trace_tag = {}) {
+        static constexpr internal::func_name func{&type_name, "::vector()"};
+        return take_base_(func);
+    }
+    static const std::string &type_name() {
         return internal::get_type_name<vector>();
     }
-    const std::string &iter_name() const {
+    static const std::string &iter_name() {
         static std::string name =
             internal::get_type_name<vector>() + "::iterator";
         return name;
     }
 
     std::size_t assert_iter(const internal::contiguous_iterator<const T> &pos,
-                            const std::string &func,
+                            const internal::func_name &func,
                             internal::skip_trace_tag = {}) const {
-        if (*elems_life_ != pos.get_observer_()) {
+        if (internal::check_bounds && elems_life_ != pos.get_observer_()) {
             y3c::internal::terminate_ub_wrong_iter(func);
         }
         pos.get_observer_().assert_iter(pos, func);
@@ -75,9 +201,9 @@ class vector {
     }
     std::size_t
     assert_iter_including_end(const internal::contiguous_iterator<const T> &pos,
-                              const std::string &func,
+                              const internal::func_name &func,
                               internal::skip_trace_tag = {}) const {
-        if (*elems_life_ != pos.get_observer_()) {
+        if (internal::check_bounds && elems_life_ != pos.get_observer_()) {
             y3c::internal::terminate_ub_wrong_iter(func);
         }
         pos.get_observer_().assert_iter_including_end(pos, func);
@@ -107,7 +233,7 @@ class vector {
      *
      */
     vector(vector &&other)
-        : base_(std::move(other.base_)),
+        : base_(other.take_base_()),
           elems_life_(std::move(other.elems_life_)), life_(this) {}
     /*!
      * \brief すべての要素をコピー
@@ -116,6 +242,8 @@ class vector {
      *
      */
     vector &operator=(const vector &other) {
+        static constexpr internal::func_name func{&type_name, "::operator=()"};
+        assert_not_pinned(func);
         this->base_ = other.base_;
         init_elems_life();
         return *this;
@@ -129,12 +257,28 @@ class vector {
      */
     vector &operator=(vector &&other) {
         if (this != std::addressof(other)) {
-            this->base_ = std::move(other.base_);
+            static constexpr internal::func_name func{&type_name,
+                                                      "::operator=()"};
+            assert_not_pinned(func);
+            this->base_ = other.take_base_(func);
             this->elems_life_ = std::move(other.elems_life_);
         }
         return *this;
     }
-    ~vector() = default;
+    /*!
+     * \brief 破棄時の処理
+     *
+     * * pin() で作った pinned が残っている場合terminateする
+     * (デストラクタなので throw_on_terminate でも例外は投げない)。
+     *
+     */
+    ~vector() noexcept {
+        if (internal::check_lifetime && pins_.pinned()) {
+            static constexpr internal::func_name func{&type_name,
+                                                      "::~vector()"};
+            y3c::internal::terminate_ub_modify_pinned_noexcept(func);
+        }
+    }
 
     using value_type = T;
     using size_type = std::size_t;
@@ -145,6 +289,9 @@ class vector {
     using const_pointer = const_ptr<T>;
     using iterator = internal::contiguous_iterator<T>;
     using const_iterator = internal::contiguous_iterator<const T>;
+    using reverse_iterator = internal::contiguous_reverse_iterator<T>;
+    using const_reverse_iterator =
+        internal::contiguous_reverse_iterator<const T>;
 
     /*!
      * \brief std::vectorからコピー構築
@@ -166,6 +313,8 @@ class vector {
      *
      */
     vector &operator=(const std::vector<T> &other) {
+        static constexpr internal::func_name func{&type_name, "::operator=()"};
+        assert_not_pinned(func);
         this->base_ = other;
         init_elems_life();
         return *this;
@@ -177,6 +326,8 @@ class vector {
      *
      */
     vector &operator=(std::vector<T> &&other) {
+        static constexpr internal::func_name func{&type_name, "::operator=()"};
+        assert_not_pinned(func);
         this->base_ = std::move(other);
         init_elems_life();
         return *this;
@@ -213,6 +364,8 @@ class vector {
      * * 既存のイテレータは無効になる
      */
     vector &operator=(std::initializer_list<T> ilist) {
+        static constexpr internal::func_name func{&type_name, "::operator=()"};
+        assert_not_pinned(func);
         base_ = ilist;
         init_elems_life();
         return *this;
@@ -224,7 +377,10 @@ class vector {
      * * 既存のイテレータは無効になる
      *
      */
-    void assign(size_type count, const T &value) {
+    void assign(size_type count, const T &value,
+                internal::skip_trace_tag = {}) {
+        static constexpr internal::func_name func{&type_name, "::assign()"};
+        assert_not_pinned(func);
         base_.assign(count, value);
         init_elems_life();
     }
@@ -235,7 +391,9 @@ class vector {
      *
      */
     template <typename InputIt>
-    void assign(InputIt first, InputIt last) {
+    void assign(InputIt first, InputIt last, internal::skip_trace_tag = {}) {
+        static constexpr internal::func_name func{&type_name, "::assign()"};
+        assert_not_pinned(func);
         base_.assign(first, last);
         init_elems_life();
     }
@@ -245,17 +403,41 @@ class vector {
      * * 既存のイテレータは無効になる
      *
      */
-    void assign(std::initializer_list<T> ilist) {
+    void assign(std::initializer_list<T> ilist,
+                internal::skip_trace_tag = {}) {
+        static constexpr internal::func_name func{&type_name, "::assign()"};
+        assert_not_pinned(func);
         base_.assign(ilist);
         init_elems_life();
     }
+    /*!
+     * \brief 範囲の要素で置き換える (C++23)
+     *
+     * * 既存のイテレータは無効になる
+     * * y3c::vector, y3c::array の場合はチェックせずに走査する
+     * * 右辺値の範囲からは要素をムーブする
+     *
+     */
+    template <typename R, typename = internal::skip_trace_tag>
+    void assign_range(R &&rg) {
+        static constexpr internal::func_name func{&type_name,
+                                                  "::assign_range()"};
+        assert_not_pinned(func);
+        base_.assign(internal::bulk_range_forward<R>(internal::bulk_range_begin(
+                         rg, internal::range_priority_high())),
+                     internal::bulk_range_forward<R>(internal::bulk_range_end(
+                         rg, internal::range_priority_high())));
+        init_elems_life();
+    }
     /*!
      * \brief 要素のクリア
      *
      * * 既存のイテレータは無効になる
      *
      */
-    void clear() {
+    void clear(internal::skip_trace_tag = {}) {
+        static constexpr internal::func_name func{&type_name, "::clear()"};
+        assert_not_pinned(func);
         base_.clear();
         init_elems_life();
     }
@@ -266,7 +448,9 @@ class vector {
      * * 再割り当てが発生した場合、既存のイテレータは無効になる
      *
      */
-    void reserve(size_type new_cap) {
+    void reserve(size_type new_cap, internal::skip_trace_tag = {}) {
+        static constexpr internal::func_name func{&type_name, "::reserve()"};
+        assert_not_pinned(func);
         base_.reserve(new_cap);
         update_elems_life();
     }
@@ -276,7 +460,10 @@ class vector {
      * * 再割り当てが発生した場合、既存のイテレータは無効になる
      *
      */
-    void shrink_to_fit() {
+    void shrink_to_fit(internal::skip_trace_tag = {}) {
+        static constexpr internal::func_name func{&type_name,
+                                                  "::shrink_to_fit()"};
+        assert_not_pinned(func);
         base_.shrink_to_fit();
         update_elems_life();
     }
@@ -291,12 +478,12 @@ class vector {
      *
      */
     iterator erase(const_iterator pos, internal::skip_trace_tag = {}) {
-        static std::string func = type_name() + "::erase()";
+        static constexpr internal::func_name func{&type_name, "::erase()"};
+        assert_not_pinned(func);
         std::size_t index = assert_iter(pos, func);
         base_.erase(base_.begin() + index);
         update_elems_life(&base_[0] + index);
-        return iterator(&base_[0] + index, elems_life_->observer(),
-                        &iter_name());
+        return iterator(&base_[0] + index, elems_life_.observer());
     }
     /*!
      * \brief 要素の削除
@@ -309,9 +496,10 @@ class vector {
      */
     iterator erase(const_iterator begin, const_iterator end,
                    internal::skip_trace_tag = {}) {
-        static std::string func = type_name() + "::erase()";
-        if (*elems_life_ != begin.get_observer_() ||
-            *elems_life_ != end.get_observer_()) {
+        static constexpr internal::func_name func{&type_name, "::erase()"};
+        assert_not_pinned(func);
+        if (internal::check_bounds && (elems_life_ != begin.get_observer_() ||
+                                       elems_life_ != end.get_observer_())) {
             y3c::internal::terminate_ub_wrong_iter(func);
         }
         begin.get_observer_().assert_range_iter(begin, end, func);
@@ -319,8 +507,42 @@ class vector {
         std::size_t index_end = y3c::internal::unwrap(end) - &base_[0];
         base_.erase(base_.begin() + index_begin, base_.begin() + index_end);
         update_elems_life(&base_[0] + index_begin);
-        return iterator(&base_[0] + index_begin, elems_life_->observer(),
-                        &iter_name());
+        return iterator(&base_[0] + index_begin, elems_life_.observer());
+    }
+    /*!
+     * \brief 条件を満たす要素をすべて削除する
+     *
+     * y3c::erase_if(), y3c::erase() から呼ばれる。
+     * remove_if() と erase() を生のイテレータに対して行い、
+     * ライフタイムの更新は最後に1回だけ行う。
+     *
+     * * 最初に削除した位置以降を指していたイテレータは無効になる
+     * (predが例外を投げた場合も同様)
+     *
+     * \return 削除した要素数
+     */
+    template <typename Pred, typename = internal::skip_trace_tag>
+    size_type erase_if_(Pred pred) {
+        static constexpr internal::func_name func{"y3c::erase_if(", &type_name,
+                                                  ")"};
+        assert_not_pinned(func);
+        auto first = std::find_if(base_.begin(), base_.end(), pred);
+        if (first == base_.end()) {
+            return 0;
+        }
+        std::size_t index = first - base_.begin();
+        auto last = first;
+        try {
+            last = std::remove_if(first, base_.end(), pred);
+        } catch (...) {
+            // 途中まで要素が移動しているので、サイズは変わらなくても無効にする
+            update_elems_life(&base_[0] + index);
+            throw;
+        }
+        size_type count = base_.end() - last;
+        base_.erase(last, base_.end());
+        update_elems_life(&base_[0] + index);
+        return count;
     }
     /*!
      * \brief 要素の追加
@@ -330,7 +552,9 @@ class vector {
      * そうでない場合、end()を指していたもののみ無効になる
      *
      */
-    void push_back(const T &value) {
+    void push_back(const T &value, internal::skip_trace_tag = {}) {
+        static constexpr internal::func_name func{&type_name, "::push_back()"};
+        assert_not_pinned(func);
         base_.push_back(value);
         update_elems_life();
     }
@@ -342,7 +566,9 @@ class vector {
      * そうでない場合、end()を指していたもののみ無効になる
      *
      */
-    void push_back(T &&value) {
+    void push_back(T &&value, internal::skip_trace_tag = {}) {
+        static constexpr internal::func_name func{&type_name, "::push_back()"};
+        assert_not_pinned(func);
         base_.push_back(std::move(value));
         update_elems_life();
     }
@@ -354,13 +580,59 @@ class vector {
      * そうでない場合、end()を指していたもののみ無効になる
      *
      */
-    template <typename... Args>
+    template <typename... Args, typename = internal::skip_trace_tag>
     reference emplace_back(Args &&...args) {
+        static constexpr internal::func_name func{&type_name,
+                                                  "::emplace_back()"};
+        assert_not_pinned(func);
         base_.emplace_back(std::forward<Args>(args)...);
         update_elems_life();
         return back();
     }
 
+    /*!
+     * \brief 末尾にまとめて要素を追加する
+     *
+     * y3c::back_insert_iterator への y3c::copy() などから呼ばれる。
+     * 要素数が分かる場合は1回だけ再割り当てし、
+     * ライフタイムの更新も最後に1回だけ行う。
+     *
+     * * 再割り当てが発生した場合、既存のイテレータは無効になる。
+     * そうでない場合、end()を指していたもののみ無効になる
+     *
+     * \param func エラーメッセージに使う、呼び出し元の関数名
+     *
+     */
+    template <typename InputIt, typename = internal::skip_trace_tag>
+    void append_(InputIt first, InputIt last, const internal::func_name &func) {
+        assert_not_pinned(func);
+        base_.insert(base_.end(), first, last);
+        update_elems_life();
+    }
+
+    /*!
+     * \brief 範囲の要素を末尾に追加する (C++23)
+     *
+     * * 要素数が分かる範囲であれば再割り当ては1回だけで、
+     * ライフタイムの更新も1回だけ行う。
+     * * y3c::vector, y3c::array の場合はチェックせずに走査する
+     * * 右辺値の範囲からは要素をムーブする
+     * * 再割り当てが発生した場合、既存のイテレータは無効になる。
+     * そうでない場合、end()を指していたもののみ無効になる
+     *
+     */
+    template <typename R, typename = internal::skip_trace_tag>
+    void append_range(R &&rg) {
+        static constexpr internal::func_name func{&type_name,
+                                                  "::append_range()"};
+        assert_not_pinned(func);
+        append_(internal::bulk_range_forward<R>(internal::bulk_range_begin(
+                    rg, internal::range_priority_high())),
+                internal::bulk_range_forward<R>(internal::bulk_range_end(
+                    rg, internal::range_priority_high())),
+                func);
+    }
+
     /*!
      * \brief 要素の挿入
      * \param pos 挿入する位置を指すイテレータ
@@ -374,12 +646,12 @@ class vector {
      */
     iterator insert(const_iterator pos, const T &value,
                     internal::skip_trace_tag = {}) {
-        static std::string func = type_name() + "::insert()";
+        static constexpr internal::func_name func{&type_name, "::insert()"};
+        assert_not_pinned(func);
         std::size_t index = assert_iter_including_end(pos, func);
         base_.insert(base_.begin() + index, value);
         update_elems_life(&base_[0] + index);
-        return iterator(&base_[0] + index, elems_life_->observer(),
-                        &iter_name());
+        return iterator(&base_[0] + index, elems_life_.observer());
     }
     /*!
      * \brief 要素の挿入
@@ -394,12 +666,12 @@ class vector {
      */
     iterator insert(const_iterator pos, T &&value,
                     internal::skip_trace_tag = {}) {
-        static std::string func = type_name() + "::insert()";
+        static constexpr internal::func_name func{&type_name, "::insert()"};
+        assert_not_pinned(func);
         std::size_t index = assert_iter_including_end(pos, func);
         base_.insert(base_.begin() + index, std::move(value));
         update_elems_life(&base_[0] + index);
-        return iterator(&base_[0] + index, elems_life_->observer(),
-                        &iter_name());
+        return iterator(&base_[0] + index, elems_life_.observer());
     }
     /*!
      * \brief 要素の挿入
@@ -415,12 +687,12 @@ class vector {
      */
     iterator insert(const_iterator pos, size_type count, const T &value,
                     internal::skip_trace_tag = {}) {
-        static std::string func = type_name() + "::insert()";
+        static constexpr internal::func_name func{&type_name, "::insert()"};
+        assert_not_pinned(func);
         std::size_t index = assert_iter_including_end(pos, func);
-        base_.insert(base_.begin() + index, count, std::move(value));
+        base_.insert(base_.begin() + index, count, value);
         update_elems_life(&base_[0] + index);
-        return iterator(&base_[0] + index, elems_life_->observer(),
-                        &iter_name());
+        return iterator(&base_[0] + index, elems_life_.observer());
     }
     /*!
      * \brief 要素の挿入
@@ -441,12 +713,12 @@ class vector {
                   std::nullptr_t>::type = nullptr>
     iterator insert(const_iterator pos, InputIt first, InputIt last,
                     internal::skip_trace_tag = {}) {
-        static std::string func = type_name() + "::insert()";
+        static constexpr internal::func_name func{&type_name, "::insert()"};
+        assert_not_pinned(func);
         std::size_t index = assert_iter_including_end(pos, func);
         base_.insert(base_.begin() + index, first, last);
         update_elems_life(&base_[0] + index);
-        return iterator(&base_[0] + index, elems_life_->observer(),
-                        &iter_name());
+        return iterator(&base_[0] + index, elems_life_.observer());
     }
     /*!
      * \brief 要素の挿入
@@ -461,12 +733,39 @@ class vector {
      */
     iterator insert(const_iterator pos, std::initializer_list<T> ilist,
                     internal::skip_trace_tag = {}) {
-        static std::string func = type_name() + "::insert()";
+        static constexpr internal::func_name func{&type_name, "::insert()"};
+        assert_not_pinned(func);
         std::size_t index = assert_iter_including_end(pos, func);
         base_.insert(base_.begin() + index, ilist);
         update_elems_life(&base_[0] + index);
-        return iterator(&base_[0] + index, elems_life_->observer(),
-                        &iter_name());
+        return iterator(&base_[0] + index, elems_life_.observer());
+    }
+    /*!
+     * \brief 範囲の要素を挿入する (C++23)
+     * \param pos 挿入する位置を指すイテレータ
+     * \param rg 挿入する要素の範囲
+     * \return 挿入された要素を指すイテレータ
+     *
+     * * 指定した位置が無効であったりこのvectorのものでない場合terminateする。
+     * * y3c::vector, y3c::array の場合はチェックせずに走査する
+     * * 右辺値の範囲からは要素をムーブする
+     * * 再割り当てが発生した場合、既存のイテレータは無効になる。
+     * そうでない場合、挿入位置以降が無効になる
+     *
+     */
+    template <typename R, typename = internal::skip_trace_tag>
+    iterator insert_range(const_iterator pos, R &&rg) {
+        static constexpr internal::func_name func{&type_name,
+                                                  "::insert_range()"};
+        assert_not_pinned(func);
+        std::size_t index = assert_iter_including_end(pos, func);
+        base_.insert(base_.begin() + index,
+                     internal::bulk_range_forward<R>(internal::bulk_range_begin(
+                         rg, internal::range_priority_high())),
+                     internal::bulk_range_forward<R>(internal::bulk_range_end(
+                         rg, internal::range_priority_high())));
+        update_elems_life(&base_[0] + index);
+        return iterator(&base_[0] + index, elems_life_.observer());
     }
     /*!
      * \brief 要素の挿入
@@ -481,12 +780,12 @@ class vector {
      */
     template <typename... Args, typename = internal::skip_trace_tag>
     iterator emplace(const_iterator pos, Args &&...args) {
-        static std::string func = type_name() + "::emplace()";
+        static constexpr internal::func_name func{&type_name, "::emplace()"};
+        assert_not_pinned(func);
         std::size_t index = assert_iter_including_end(pos, func);
         base_.emplace(base_.begin() + index, std::forward<Args>(args)...);
         update_elems_life(&base_[0] + index);
-        return iterator(&base_[0] + index, elems_life_->observer(),
-                        &iter_name());
+        return iterator(&base_[0] + index, elems_life_.observer());
     }
 
     /*!
@@ -496,7 +795,9 @@ class vector {
      * * 再割り当てが発生した場合、既存のイテレータは無効になる。
      * そうでない場合、削除された要素とend()を指すもののみ無効になる
      */
-    void resize(size_type count) {
+    void resize(size_type count, internal::skip_trace_tag = {}) {
+        static constexpr internal::func_name func{&type_name, "::resize()"};
+        assert_not_pinned(func);
         base_.resize(count);
         update_elems_life();
     }
@@ -508,7 +809,10 @@ class vector {
      * * 再割り当てが発生した場合、既存のイテレータは無効になる。
      * そうでない場合、削除された要素とend()を指すもののみ無効になる
      */
-    void resize(size_type count, const T &value) {
+    void resize(size_type count, const T &value,
+                internal::skip_trace_tag = {}) {
+        static constexpr internal::func_name func{&type_name, "::resize()"};
+        assert_not_pinned(func);
         base_.resize(count, value);
         update_elems_life();
     }
@@ -520,10 +824,11 @@ class vector {
      *
      */
     void pop_back(internal::skip_trace_tag = {}) {
-        if (base_.empty()) {
-            static std::string func = type_name() + "::pop_back()";
+        static constexpr internal::func_name func{&type_name, "::pop_back()"};
+        if (internal::check_bounds && base_.empty()) {
             y3c::internal::terminate_ub_out_of_range(func, 0, -1);
         }
+        assert_not_pinned(func);
         base_.pop_back();
         update_elems_life();
     }
@@ -536,11 +841,11 @@ class vector {
      */
     reference at(size_type n, internal::skip_trace_tag = {}) {
         if (n >= base_.size()) {
-            static std::string func = type_name() + "::at()";
-            throw y3c::out_of_range(func, base_.size(),
-                                    static_cast<std::ptrdiff_t>(n));
+            static constexpr internal::func_name func{&type_name, "::at()"};
+            internal::throw_out_of_range(func, base_.size(),
+                                         static_cast<std::ptrdiff_t>(n));
         }
-        return reference(&this->base_[n], elems_life_->observer());
+        return reference(&this->base_[n], elems_life_.observer());
     }
     /*!
      * \brief 要素アクセス(const)
@@ -550,11 +855,11 @@ class vector {
      */
     const_reference at(size_type n, internal::skip_trace_tag = {}) const {
         if (n >= base_.size()) {
-            static std::string func = type_name() + "::at()";
-            throw y3c::out_of_range(func, base_.size(),
-                                    static_cast<std::ptrdiff_t>(n));
+            static constexpr internal::func_name func{&type_name, "::at()"};
+            internal::throw_out_of_range(func, base_.size(),
+                                         static_cast<std::ptrdiff_t>(n));
         }
-        return const_reference(&this->base_[n], elems_life_->observer());
+        return const_reference(&this->base_[n], elems_life_.observer());
     }
     /*!
      * \brief 要素アクセス
@@ -564,12 +869,13 @@ class vector {
      */
     template <typename = internal::skip_trace_tag>
     reference operator[](size_type n) {
-        if (n >= base_.size()) {
-            static std::string func = type_name() + "::operator[]()";
+        if (internal::check_bounds && n >= base_.size()) {
+            static constexpr internal::func_name func{&type_name,
+                                                      "::operator[]()"};
             y3c::internal::terminate_ub_out_of_range(
                 func, base_.size(), static_cast<std::ptrdiff_t>(n));
         }
-        return reference(&this->base_[n], elems_life_->observer());
+        return reference(&this->base_[n], elems_life_.observer());
     }
     /*!
      * \brief 要素アクセス(const)
@@ -579,12 +885,13 @@ class vector {
      */
     template <typename = internal::skip_trace_tag>
     const_reference operator[](size_type n) const {
-        if (n >= base_.size()) {
-            static std::string func = type_name() + "::operator[]()";
+        if (internal::check_bounds && n >= base_.size()) {
+            static constexpr internal::func_name func{&type_name,
+                                                      "::operator[]()"};
             y3c::internal::terminate_ub_out_of_range(
                 func, base_.size(), static_cast<std::ptrdiff_t>(n));
         }
-        return const_reference(&this->base_[n], elems_life_->observer());
+        return const_reference(&this->base_[n], elems_life_.observer());
     }
     /*!
      * \brief 先頭の要素へのアクセス
@@ -593,11 +900,11 @@ class vector {
      *
      */
     reference front(internal::skip_trace_tag = {}) {
-        if (base_.empty()) {
-            static std::string func = type_name() + "::front()";
+        if (internal::check_bounds && base_.empty()) {
+            static constexpr internal::func_name func{&type_name, "::front()"};
             y3c::internal::terminate_ub_out_of_range(func, 0, 0);
         }
-        return reference(&base_.front(), elems_life_->observer());
+        return reference(&base_.front(), elems_life_.observer());
     }
     /*!
      * \brief 先頭の要素へのアクセス(const)
@@ -606,11 +913,11 @@ class vector {
      *
      */
     const_reference front(internal::skip_trace_tag = {}) const {
-        if (base_.empty()) {
-            static std::string func = type_name() + "::front()";
+        if (internal::check_bounds && base_.empty()) {
+            static constexpr internal::func_name func{&type_name, "::front()"};
             y3c::internal::terminate_ub_out_of_range(func, 0, 0);
         }
-        return const_reference(&base_.front(), elems_life_->observer());
+        return const_reference(&base_.front(), elems_life_.observer());
     }
     /*!
      * \brief 末尾の要素へのアクセス
@@ -619,11 +926,11 @@ class vector {
      *
      */
     reference back(internal::skip_trace_tag = {}) {
-        if (base_.empty()) {
-            static std::string func = type_name() + "::back()";
+        if (internal::check_bounds && base_.empty()) {
+            static constexpr internal::func_name func{&type_name, "::back()"};
             y3c::internal::terminate_ub_out_of_range(func, 0, -1);
         }
-        return reference(&base_.back(), elems_life_->observer());
+        return reference(&base_.back(), elems_life_.observer());
     }
     /*!
      * \brief 末尾の要素へのアクセス(const)
@@ -632,11 +939,11 @@ class vector {
      *
      */
     const_reference back(internal::skip_trace_tag = {}) const {
-        if (base_.empty()) {
-            static std::string func = type_name() + "::back()";
+        if (internal::check_bounds && base_.empty()) {
+            static constexpr internal::func_name func{&type_name, "::back()"};
             y3c::internal::terminate_ub_out_of_range(func, 0, -1);
         }
-        return const_reference(&base_.back(), elems_life_->observer());
+        return const_reference(&base_.back(), elems_life_.observer());
     }
 
     /*!
@@ -647,9 +954,9 @@ class vector {
      */
     pointer data() {
         if (base_.empty()) {
-            return pointer(nullptr, elems_life_->observer());
+            return pointer(nullptr, elems_life_.observer());
         }
-        return pointer(&this->base_[0], elems_life_->observer());
+        return pointer(&this->base_[0], elems_life_.observer());
     }
     /*!
      * \brief 先頭要素へのconstポインタを取得
@@ -659,9 +966,9 @@ class vector {
      */
     const_pointer data() const {
         if (base_.empty()) {
-            return const_pointer(nullptr, elems_life_->observer());
+            return const_pointer(nullptr, elems_life_.observer());
         }
-        return const_pointer(&this->base_[0], elems_life_->observer());
+        return const_pointer(&this->base_[0], elems_life_.observer());
     }
 
     /*!
@@ -672,10 +979,9 @@ class vector {
      */
     iterator begin() {
         if (base_.empty()) {
-            return iterator(nullptr, elems_life_->observer(), &iter_name());
+            return iterator(nullptr, elems_life_.observer());
         }
-        return iterator(&this->base_.front(), elems_life_->observer(),
-                        &iter_name());
+        return iterator(&this->base_.front(), elems_life_.observer());
     }
     /*!
      * \brief 先頭要素を指すconstイテレータを取得
@@ -685,11 +991,9 @@ class vector {
      */
     const_iterator begin() const {
         if (base_.empty()) {
-            return const_iterator(nullptr, elems_life_->observer(),
-                                  &iter_name());
+            return const_iterator(nullptr, elems_life_.observer());
         }
-        return const_iterator(&this->base_.front(), elems_life_->observer(),
-                              &iter_name());
+        return const_iterator(&this->base_.front(), elems_life_.observer());
     }
     /*!
      * \brief 先頭要素を指すconstイテレータを取得
@@ -719,6 +1023,63 @@ class vector {
      *
      */
     const_iterator cend() const { return begin() + base_.size(); }
+    /*!
+     * \brief 末尾要素を指す逆イテレータを取得
+     *
+     * * end() を base() とする逆イテレータ。
+     * * サイズが0の場合無効なイテレータを返す。
+     *
+     */
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    /*!
+     * \brief 末尾要素を指すconst逆イテレータを取得
+     */
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(end());
+    }
+    /*!
+     * \brief 末尾要素を指すconst逆イテレータを取得
+     */
+    const_reverse_iterator crbegin() const { return rbegin(); }
+    /*!
+     * \brief 先頭要素の前を指す逆イテレータを取得
+     *
+     * * begin() を base() とする逆イテレータ。
+     * * サイズが0の場合無効なイテレータを返す。
+     *
+     */
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    /*!
+     * \brief 先頭要素の前を指すconst逆イテレータを取得
+     */
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(begin());
+    }
+    /*!
+     * \brief 先頭要素の前を指すconst逆イテレータを取得
+     */
+    const_reverse_iterator crend() const { return rend(); }
+
+    /*!
+     * \brief y3c::range() の実装
+     */
+    internal::contiguous_range<T> get_range_() {
+        static constexpr internal::func_name func{"y3c::range(", &type_name,
+                                                  ")"};
+        T *begin = base_.empty() ? nullptr : &base_[0];
+        return internal::contiguous_range<T>(begin, begin + base_.size(),
+                                             elems_life_.observer(), func);
+    }
+    /*!
+     * \brief y3c::range() の実装(const)
+     */
+    internal::contiguous_range<const T> get_range_() const {
+        static constexpr internal::func_name func{"y3c::range(", &type_name,
+                                                  ")"};
+        const T *begin = base_.empty() ? nullptr : &base_[0];
+        return internal::contiguous_range<const T>(
+            begin, begin + base_.size(), elems_life_.observer(), func);
+    }
 
     /*!
      * \brief sizeが0かどうかを返す
@@ -743,13 +1104,145 @@ class vector {
      * * 双方のend()を指す既存のイテレータは無効になる。
      *
      */
-    void swap(vector &other) {
+    void swap(vector &other, internal::skip_trace_tag = {}) {
+        static constexpr internal::func_name func{&type_name, "::swap()"};
+        assert_not_pinned(func);
+        other.assert_not_pinned(func);
         base_.swap(other.base_);
         elems_life_.swap(other.elems_life_);
         update_elems_life(&base_[0] + base_.size());
         other.update_elems_life(&other.base_[0] + other.base_.size());
     }
 
+    /*!
+     * \brief batch() が返す、ライフタイムの更新をまとめる範囲
+     *
+     * * 有効な間の末尾への要素の追加 (push_back(), emplace_back(),
+     * append_range(), resize() での拡大など) による無効化は、
+     * 間にイテレータを取得したり移動したりしなければ1つの記録にまとめられる。
+     * * ただしまとめるのは batch() の有無に関わらずlife側で行っていて、
+     * transaction 自体は何も保留しない。
+     * そのため途中で取得したイテレータも、それより前に取得していたイテレータも、
+     * batch() の外と同じようにその場でチェックされる。
+     *
+     */
+    class transaction {
+        friend class vector;
+
+        transaction() noexcept {}
+
+      public:
+        transaction(const transaction &) = delete;
+        transaction &operator=(const transaction &) = delete;
+        transaction(transaction &&) noexcept {}
+        transaction &operator=(transaction &&) = delete;
+        ~transaction() = default;
+
+        /*!
+         * \brief 何もしない (保留している記録は無い)
+         */
+        void commit() noexcept {}
+    };
+    /*!
+     * \brief ライフタイムの更新をまとめる範囲を開始する
+     *
+     * `auto tx = v.batch();` のように使う。
+     * パススルーモードでも使えるようにする場合は y3c::batch(v) を使う。
+     *
+     * \sa transaction
+     */
+    transaction batch() { return transaction(); }
+
+    /*!
+     * \brief pin() が返す、要素数と領域の変更を禁止している間の要素のビュー
+     *
+     * * 有効な間に元のvectorの要素数や領域を変更する関数 (push_back(),
+     * insert(), resize(), clear() など) を呼ぶと、その場でterminateする。
+     * 要素の値の変更はできる。
+     * * そのため要素アクセス時には範囲のチェックだけを行い、
+     * 寿命や無効化のチェックはしない。
+     * 要素も wrap<T&> ではなく U& で得られる。
+     * * vectorより長く使ってはいけない
+     * (pinnedが残っている間にvectorを破棄するとterminateする)。
+     *
+     */
+    template <typename U>
+    class pinned {
+        const vector *v_;
+        U *ptr_;
+        std::size_t size_;
+
+        friend class vector;
+
+        /*!
+         * 寿命のチェックをしない場合は数えない (変更もチェックしないので)
+         */
+        pinned(const vector &v, U *ptr)
+            : v_(nullptr), ptr_(ptr), size_(v.base_.size()) {
+            if (internal::check_lifetime) {
+                v_ = std::addressof(v);
+                v_->pins_.increment();
+            }
+        }
+
+      public:
+        using element_type = U;
+        using size_type = std::size_t;
+        using iterator = U *;
+
+        pinned(const pinned &) = delete;
+        pinned &operator=(const pinned &) = delete;
+        pinned(pinned &&other) noexcept
+            : v_(other.v_), ptr_(other.ptr_), size_(other.size_) {
+            other.v_ = nullptr;
+        }
+        pinned &operator=(pinned &&) = delete;
+        ~pinned() {
+            if (v_) {
+                v_->pins_.decrement();
+            }
+        }
+
+        size_type size() const noexcept { return size_; }
+        bool empty() const noexcept { return size_ == 0; }
+        U *data() const noexcept { return ptr_; }
+        iterator begin() const noexcept { return ptr_; }
+        iterator end() const noexcept { return ptr_ + size_; }
+
+        /*!
+         * \brief 要素アクセス
+         *
+         * * インデックスが範囲外の場合terminateする。
+         *
+         */
+        template <typename = internal::skip_trace_tag>
+        U &operator[](size_type n) const {
+            if (internal::check_bounds && n >= size_) {
+                static constexpr internal::func_name func{
+                    &type_name, "::pinned::operator[]()"};
+                y3c::internal::terminate_ub_out_of_range(
+                    func, size_, static_cast<std::ptrdiff_t>(n));
+            }
+            return ptr_[n];
+        }
+    };
+    /*!
+     * \brief 要素数と領域の変更を禁止して、要素をチェック無しで参照する
+     *
+     * `auto p = v.pin();` のように使う。
+     * pのスコープを抜けるまで、このvectorの要素数や領域を変更すると
+     * terminateする代わりに、pを通した要素アクセスは範囲のチェックだけになる。
+     *
+     * \sa pinned
+     */
+    pinned<T> pin() { return pinned<T>(*this, base_.data()); }
+    /*!
+     * \brief 要素数と領域の変更を禁止して、要素をチェック無しで参照する(const)
+     */
+    pinned<const T> pin() const {
+        return pinned<const T>(*this, base_.data());
+    }
+
     /*!
      * \brief const std::vector へのキャスト
      */
@@ -768,6 +1261,62 @@ const std::vector<T> &unwrap(const vector<T> &wrapper) noexcept {
     return static_cast<const std::vector<T> &>(wrapper);
 }
 
+/*!
+ * \brief 範囲のチェックをループの開始時に1回だけ行う range-for 用の範囲
+ *
+ * `for (auto &x : y3c::range(v))` のように使う。
+ *
+ * * 要素は wrap<T&> ではなく T& で得られる。
+ * * ループ中にvectorが変更され現在位置が無効になった場合terminateする。
+ *
+ */
+template <typename T>
+internal::contiguous_range<T> range(vector<T> &v) {
+    return v.get_range_();
+}
+template <typename T>
+internal::contiguous_range<const T> range(const vector<T> &v) {
+    return v.get_range_();
+}
+template <typename T>
+void range(const vector<T> &&) = delete;
+
+/*!
+ * \brief 条件を満たす要素をすべて削除する (std::erase_if)
+ *
+ * * 最初に削除した位置以降を指していたイテレータは無効になる
+ *
+ * \return 削除した要素数
+ * \sa [erase_if -
+ * cpprefjp](https://cpprefjp.github.io/reference/vector/erase_if_free.html)
+ */
+template <typename T, typename Pred>
+typename vector<T>::size_type erase_if(vector<T> &c, Pred pred) {
+    return c.erase_if_(pred);
+}
+/*!
+ * \brief 値が等しい要素をすべて削除する (std::erase)
+ *
+ * \return 削除した要素数
+ * \sa [erase -
+ * cpprefjp](https://cpprefjp.github.io/reference/vector/erase_free.html)
+ */
+template <typename T, typename U>
+typename vector<T>::size_type erase(vector<T> &c, const U &value) {
+    return c.erase_if_([&value](const T &elem) { return elem == value; });
+}
+
+/*!
+ * \brief v.batch() と同じ
+ *
+ * パススルーモードでは何もしないオブジェクトを返す。
+ *
+ */
+template <typename T>
+typename vector<T>::transaction batch(vector<T> &v) {
+    return v.batch();
+}
+
 template <typename T>
 void swap(vector<T> &lhs, vector<T> &rhs) {
     lhs.swap(rhs);
@@ -25,6 +25,7 @@ Y3C_DLL const char *Y3C_CALL ub_wrong_iter();
 Y3C_DLL const char *Y3C_CALL ub_invalid_iter();
 Y3C_DLL const char *Y3C_CALL ub_iter_after_end();
 Y3C_DLL const char *Y3C_CALL ub_iter_before_begin();
+Y3C_DLL const char *Y3C_CALL ub_modify_pinned();
 } // namespace what
 } // namespace internal
 } // namespace y3c
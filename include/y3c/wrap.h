@@ -29,7 +29,7 @@ class wrap {
     static_assert(!std::is_const<base_type>::value,
                   "y3c::wrap cannot have const value");
 
-    const std::string &type_name() const {
+    static const std::string &type_name() {
         return internal::get_type_name<wrap>();
     }
 
@@ -108,7 +108,7 @@ class wrap {
                                       std::nullptr_t>::type = nullptr,
               typename = internal::skip_trace_tag>
     wrap<E &> operator[](std::ptrdiff_t i) {
-        static std::string func = type_name() + "::operator[]()";
+        static constexpr internal::func_name func{&type_name, "::operator[]()"};
         return wrap<E &>(life_.observer().assert_ptr(&base_[i], func),
                          life_.observer());
     }
@@ -124,7 +124,7 @@ class wrap {
                                       std::nullptr_t>::type = nullptr,
               typename = internal::skip_trace_tag>
     wrap<const E &> operator[](std::ptrdiff_t i) const {
-        static std::string func = type_name() + "::operator[]()";
+        static constexpr internal::func_name func{&type_name, "::operator[]()"};
         return wrap<const E &>(life_.observer().assert_ptr(&base_[i], func),
                                life_.observer());
     }
@@ -173,11 +173,11 @@ class wrap<element_type &> {
     element_type *ptr_;
     internal::life_observer observer_;
 
-    const std::string &type_name() const {
+    static const std::string &type_name() {
         return internal::get_type_name<wrap>();
     }
 
-    element_type *assert_ptr(const std::string &func,
+    element_type *assert_ptr(const internal::func_name &func,
                              internal::skip_trace_tag = {}) const {
         return observer_.assert_ptr(ptr_, func);
     }
@@ -219,7 +219,7 @@ class wrap<element_type &> {
      */
     template <typename V, typename = internal::skip_trace_tag>
     wrap &operator=(V &&args) {
-        static std::string func = type_name() + "::operator=()";
+        static constexpr internal::func_name func{&type_name, "::operator=()"};
         *assert_ptr(func) = std::forward<V>(args);
         return *this;
     }
@@ -233,9 +233,9 @@ class wrap<element_type &> {
      */
     template <typename = internal::skip_trace_tag>
     wrap &operator=(const wrap &other) {
-        static std::string func = type_name() + "::operator=()";
-        static std::string func2 =
-            "cast from " + other.type_name() + " to reference";
+        static constexpr internal::func_name func{&type_name, "::operator=()"};
+        static constexpr internal::func_name func2{"cast from ", &type_name,
+                                                   " to reference"};
         *assert_ptr(func) = *other.assert_ptr(func2);
         return *this;
     }
@@ -247,9 +247,10 @@ class wrap<element_type &> {
     template <typename = internal::skip_trace_tag>
     wrap &operator=(wrap &&other) {
         if (this != std::addressof(other)) {
-            static std::string func = type_name() + "::operator=()";
-            static std::string func2 =
-                "cast from " + other.type_name() + " to reference";
+            static constexpr internal::func_name func{&type_name,
+                                                      "::operator=()"};
+            static constexpr internal::func_name func2{"cast from ", &type_name,
+                                                       " to reference"};
             *assert_ptr(func) = std::move(*other.assert_ptr(func2));
         }
         return *this;
@@ -268,7 +269,8 @@ class wrap<element_type &> {
      */
     template <typename = internal::skip_trace_tag>
     operator element_type &() {
-        static std::string func2 = "cast from " + type_name() + " to reference";
+        static constexpr internal::func_name func2{"cast from ", &type_name,
+                                                   " to reference"};
         return *assert_ptr(func2);
     }
 
@@ -284,7 +286,7 @@ class wrap<element_type &> {
                                       std::nullptr_t>::type = nullptr,
               typename = internal::skip_trace_tag>
     wrap<E &> operator[](std::ptrdiff_t i) {
-        static std::string func = type_name() + "::operator[]()";
+        static constexpr internal::func_name func{&type_name, "::operator[]()"};
         return wrap<E &>(&assert_ptr(func)[0][i], observer_);
     }
 
@@ -296,7 +298,8 @@ class wrap<element_type &> {
 template <typename element_type>
 element_type &unwrap(const wrap<element_type &> &wrapper,
                      internal::skip_trace_tag) {
-    static std::string func = "y3c::unwrap(" + wrapper.type_name() + ")";
+    static constexpr internal::func_name func{
+        "y3c::unwrap(", &wrap<element_type &>::type_name, ")"};
     return *wrapper.assert_ptr(func);
 }
 
@@ -320,11 +323,11 @@ class wrap<element_type *> {
     internal::life_observer observer_;
     internal::life life_;
 
-    const std::string &type_name() const {
+    static const std::string &type_name() {
         return internal::get_type_name<wrap>();
     }
 
-    element_type *assert_ptr(const std::string &func,
+    element_type *assert_ptr(const internal::func_name &func,
                              internal::skip_trace_tag = {}) const {
         return observer_.assert_ptr(ptr_, func);
     }
@@ -392,6 +395,9 @@ class wrap<element_type *> {
 
     template <typename T>
     friend class wrap;
+    const internal::life_observer &get_observer_() const {
+        return this->observer_;
+    }
 
     /*!
      * \brief 要素アクセス
@@ -402,7 +408,7 @@ class wrap<element_type *> {
      */
     template <typename E = element_type, typename = internal::skip_trace_tag>
     wrap<E &> operator*() const {
-        static std::string func = type_name() + "::operator*()";
+        static constexpr internal::func_name func{&type_name, "::operator*()"};
         return wrap<E &>(assert_ptr(func), observer_);
     }
     /*!
@@ -414,7 +420,7 @@ class wrap<element_type *> {
      */
     template <typename = internal::skip_trace_tag>
     element_type *operator->() const {
-        static std::string func = type_name() + "::operator->()";
+        static constexpr internal::func_name func{&type_name, "::operator->()"};
         return assert_ptr(func);
     }
 
@@ -457,7 +463,7 @@ class wrap<element_type *> {
      */
     template <typename E = element_type, typename = internal::skip_trace_tag>
     wrap<E &> operator[](std::ptrdiff_t n) const {
-        static std::string func = type_name() + "::operator[]()";
+        static constexpr internal::func_name func{&type_name, "::operator[]()"};
         return wrap<E &>((*this + n).assert_ptr(func), observer_);
     }
 
@@ -102,6 +102,7 @@ void print_y3c_exception(std::ostream &stream, const terminate_detail &e) {
         define_ub_message(ub_invalid_iter);
         define_ub_message(ub_iter_after_end);
         define_ub_message(ub_iter_before_begin);
+        define_ub_message(ub_modify_pinned);
 
 #undef define_ub_message
 
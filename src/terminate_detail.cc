@@ -1,5 +1,6 @@
 #include "y3c/terminate.h"
 #include <cpptrace/basic.hpp>
+#include <cstdlib>
 
 namespace y3c {
 namespace internal {
@@ -18,6 +19,19 @@ terminate_detail::terminate_detail(terminate_type type, const char *e_class,
 bool throw_on_terminate =
     (std::set_terminate(handle_final_terminate_message), false);
 
+static std::size_t read_check_sample_interval() {
+    const char *env = std::getenv("Y3C_SAMPLE");
+    if (env) {
+        char *end;
+        unsigned long interval = std::strtoul(env, &end, 10);
+        if (end != env && *end == '\0' && interval > 0) {
+            return interval;
+        }
+    }
+    return 1;
+}
+std::atomic<std::size_t> check_sample_interval{read_check_sample_interval()};
+
 std::atomic<int> exception_base::last_exception_id;
 std::unordered_map<int, terminate_detail> exception_base::exceptions;
 
@@ -33,6 +33,10 @@ const char *ub_iter_after_end() {
 const char *ub_iter_before_begin() {
     return "iterated back beyond the begin() of container.";
 }
+const char *ub_modify_pinned() {
+    return "attempted to resize, reallocate or destroy the container while "
+           "it is pinned.";
+}
 } // namespace what
 } // namespace internal
 } // namespace y3c
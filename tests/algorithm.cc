@@ -0,0 +1,85 @@
+#include <y3c/algorithm.h>
+#include <y3c/vector.h>
+#include <y3c/array.h>
+#include <functional>
+#include <iterator>
+
+#ifdef Y3C_DOCTEST_NESTED_HEADER
+#include <doctest/doctest.h>
+#else
+#include <doctest.h>
+#endif
+
+TEST_CASE("algorithm") {
+    y3c::internal::throw_on_terminate = true;
+
+    y3c::vector<int> v = {5, 3, 1, 4, 2};
+    SUBCASE("sort") {
+        y3c::sort(v.begin(), v.end());
+        CHECK(unwrap(v) == std::vector<int>{1, 2, 3, 4, 5});
+        y3c::sort(v.begin(), v.end(), std::greater<int>());
+        CHECK(unwrap(v) == std::vector<int>{5, 4, 3, 2, 1});
+        y3c::sort(v.begin() + 1, v.begin() + 3);
+        CHECK(unwrap(v) == std::vector<int>{5, 3, 4, 2, 1});
+    }
+    SUBCASE("copy") {
+        y3c::vector<int> w(5);
+        auto it = y3c::copy(v.cbegin(), v.cend(), w.begin());
+        CHECK_EQ(unwrap(w), unwrap(v));
+        CHECK_EQ(unwrap(it), unwrap(w.end()));
+
+        y3c::array<int, 3> a{};
+        y3c::copy(v.begin() + 2, v.end(), a.begin());
+        CHECK(unwrap(a) == std::array<int, 3>{1, 4, 2});
+        CHECK_THROWS_AS(y3c::copy(v.begin(), v.end(), a.begin()),
+                        y3c::internal::ub_iter_after_end);
+
+        std::vector<int> s;
+        y3c::copy(v.begin(), v.end(), std::back_inserter(s));
+        CHECK_EQ(s, unwrap(v));
+
+        y3c::vector<int> b = {0};
+        auto b_first = b.begin();
+        auto bi = y3c::copy(v.begin(), v.end(), y3c::back_inserter(b));
+        CHECK(unwrap(b) == std::vector<int>{0, 5, 3, 1, 4, 2});
+        *bi = 6;
+        CHECK_EQ(unwrap(b.back()), 6);
+        CHECK_THROWS_AS(*b_first, y3c::internal::ub_access_deleted);
+        CHECK_THROWS_AS(y3c::copy(v.end(), v.begin(), y3c::back_inserter(b)),
+                        y3c::internal::ub_out_of_range);
+    }
+    SUBCASE("find") {
+        auto it = y3c::find(v.begin(), v.end(), 4);
+        CHECK_EQ(it - v.begin(), 3);
+        CHECK_EQ(unwrap(*it), 4);
+        CHECK(y3c::find(v.begin(), v.end(), 6) == v.end());
+        const y3c::vector<int> &cv = v;
+        CHECK(y3c::find(cv.begin(), cv.end(), 5) == cv.begin());
+    }
+    SUBCASE("lower_bound") {
+        y3c::sort(v.begin(), v.end());
+        CHECK_EQ(y3c::lower_bound(v.begin(), v.end(), 3) - v.begin(), 2);
+        CHECK(y3c::lower_bound(v.begin(), v.end(), 6) == v.end());
+        y3c::sort(v.begin(), v.end(), std::greater<int>());
+        CHECK_EQ(y3c::lower_bound(v.begin(), v.end(), 2, std::greater<int>()) -
+                     v.begin(),
+                 3);
+    }
+    SUBCASE("empty") {
+        y3c::vector<int> e;
+        y3c::sort(e.begin(), e.end());
+        CHECK(y3c::find(e.begin(), e.end(), 1) == e.end());
+    }
+    SUBCASE("invalid range") {
+        y3c::vector<int> w = {1, 2, 3};
+        CHECK_THROWS_AS(y3c::sort(v.begin(), w.end()),
+                        y3c::internal::ub_wrong_iter);
+        CHECK_THROWS_AS(y3c::sort(v.end(), v.begin()),
+                        y3c::internal::ub_out_of_range);
+        auto begin = v.begin();
+        auto end = v.end();
+        v.push_back(6);
+        CHECK_THROWS_AS(y3c::sort(begin, end),
+                        y3c::internal::ub_access_deleted);
+    }
+}
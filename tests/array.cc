@@ -112,4 +112,26 @@ TEST_CASE("array") {
         CHECK_EQ(unwrap(b)[0].val, 100);
         CHECK_EQ(unwrap(b)[1].val, 200);
     }
+    SUBCASE("range") {
+        y3c::array<A, 3> a{100, 200, 300};
+        int sum = 0;
+        for (A &x : y3c::range(a)) {
+            x.val += 1;
+            sum += x.val;
+        }
+        CHECK_EQ(sum, 603);
+        const y3c::array<A, 3> &ca = a;
+        sum = 0;
+        for (const A &x : y3c::range(ca)) {
+            sum += x.val;
+        }
+        CHECK_EQ(sum, 603);
+        y3c::array<A, 0> e;
+        int count = 0;
+        for (A &x : y3c::range(e)) {
+            (void)x;
+            count++;
+        }
+        CHECK_EQ(count, 0);
+    }
 }
@@ -0,0 +1,48 @@
+// このテストは範囲外アクセスのみチェックするレベルでビルドする
+#define Y3C_CHECK_LEVEL 1 // Y3C_CHECK_BOUNDS
+#include <y3c/vector.h>
+#include <y3c/array.h>
+#include <y3c/shared_ptr.h>
+
+#ifdef Y3C_DOCTEST_NESTED_HEADER
+#include <doctest/doctest.h>
+#else
+#include <doctest.h>
+#endif
+
+TEST_CASE("check level") {
+    y3c::internal::throw_on_terminate = true;
+
+    static_assert(Y3C_CHECK_LEVEL == Y3C_CHECK_BOUNDS, "");
+    static_assert(y3c::internal::check_bounds, "");
+    static_assert(!y3c::internal::check_lifetime, "");
+    static_assert(y3c::internal::check_nullptr, "");
+
+    y3c::vector<int> v = {1, 2, 3};
+    y3c::vector<int> v2 = {1, 2, 3};
+    SUBCASE("bounds") {
+        CHECK_THROWS_AS(v[3], y3c::internal::ub_out_of_range);
+        CHECK_THROWS_AS(v.end() + 1, y3c::internal::ub_iter_after_end);
+        CHECK_THROWS_AS(v.begin() - 1, y3c::internal::ub_iter_before_begin);
+        CHECK_THROWS_AS(*v.end(), y3c::internal::ub_out_of_range);
+        CHECK_THROWS_AS(v.erase(v2.begin()), y3c::internal::ub_wrong_iter);
+        y3c::array<int, 3> a = {1, 2, 3};
+        CHECK_THROWS_AS(a[3], y3c::internal::ub_out_of_range);
+    }
+    SUBCASE("at() throws regardless of level") {
+        CHECK_THROWS_AS(v.at(3), std::out_of_range);
+    }
+    SUBCASE("nullptr") {
+        y3c::shared_ptr<int> p;
+        CHECK_THROWS_AS(*p, y3c::internal::ub_access_nullptr);
+    }
+    SUBCASE("lifetime is not checked") {
+        auto it = v.begin() + 1;
+        v.erase(v.begin());
+        // 範囲内であれば無効になったイテレータの使用もチェックされない
+        CHECK_EQ(unwrap(*it), 3);
+        CHECK_NOTHROW(it - 1);
+        // 無効化の記録も残さない
+        CHECK_EQ(it.get_observer_().invalidations_size(), 0);
+    }
+}
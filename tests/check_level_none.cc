@@ -0,0 +1,48 @@
+// このテストはすべてのチェックを無効にしたレベルでビルドする
+#define Y3C_CHECK_LEVEL 0 // Y3C_CHECK_NONE
+#include <y3c/vector.h>
+#include <y3c/array.h>
+
+#ifdef Y3C_DOCTEST_NESTED_HEADER
+#include <doctest/doctest.h>
+#else
+#include <doctest.h>
+#endif
+
+TEST_CASE("check level none") {
+    y3c::internal::throw_on_terminate = true;
+
+    static_assert(Y3C_CHECK_LEVEL == Y3C_CHECK_NONE, "");
+    static_assert(!y3c::internal::check_bounds, "");
+    static_assert(!y3c::internal::check_lifetime, "");
+    static_assert(!y3c::internal::check_nullptr, "");
+    CHECK_FALSE(y3c::internal::check_sampled());
+
+    SUBCASE("container") {
+        y3c::vector<int> v = {1, 2, 3};
+        auto it = v.begin();
+        ++it;
+        it += 1;
+        CHECK_EQ(unwrap(*it), 3);
+        CHECK_EQ(it - v.begin(), 2);
+        CHECK(it.get_validator_().epoch() == nullptr);
+        v.push_back(4);
+        CHECK_EQ(it.get_observer_().invalidations_size(), 0);
+    }
+    SUBCASE("observer without type name") {
+        // 型名を持たないlifeやnullptrのobserverでもイテレータ操作は何もしない
+        int a[3] = {1, 2, 3};
+        y3c::internal::life l(&a[0], &a[3]);
+        y3c::internal::contiguous_iterator<int> it(&a[0], l.observer());
+        ++it;
+        it++;
+        --it;
+        CHECK_EQ(unwrap(*it), 2);
+        CHECK_EQ(unwrap(it[1]), 3);
+        y3c::internal::contiguous_iterator<int> null_it(
+            &a[0], y3c::internal::life_observer(nullptr));
+        ++null_it;
+        CHECK_EQ(unwrap(*null_it), 2);
+        CHECK_EQ(null_it - it, 0);
+    }
+}
@@ -1,5 +1,7 @@
 #include <y3c/terminate.h>
 #include <y3c/iterator.h>
+#include <y3c/vector.h>
+#include <y3c/array.h>
 #ifdef Y3C_DOCTEST_NESTED_HEADER
 #include <doctest/doctest.h>
 #else
@@ -20,19 +22,21 @@ struct A {
     int val = -1;
 };
 
+const std::string &iter_name() {
+    static std::string name = "hoge";
+    return name;
+}
+
 TEST_CASE("iter") {
     y3c::internal::throw_on_terminate = true;
 
     A array[5] = {100, 200, 300, 400, 500};
     A array2[4] = {500, 600, 700, 800};
-    y3c::internal::life *life_ = new y3c::internal::life(&array[0], &array[4]);
-    std::string name = "hoge";
-    y3c::internal::contiguous_iterator<A> p(&array[1], life_->observer(),
-                                            &name);
-    y3c::internal::contiguous_iterator<A> p0(&array[0], life_->observer(),
-                                             &name);
-    y3c::internal::contiguous_iterator<A> p4(&array[4], life_->observer(),
-                                             &name);
+    y3c::internal::life *life_ =
+        new y3c::internal::life(&array[0], &array[4], &iter_name);
+    y3c::internal::contiguous_iterator<A> p(&array[1], life_->observer());
+    y3c::internal::contiguous_iterator<A> p0(&array[0], life_->observer());
+    y3c::internal::contiguous_iterator<A> p4(&array[4], life_->observer());
 
     CHECK_EQ(unwrap(p), &array[1]);
     CHECK_EQ(unwrap(*p).val, 200);
@@ -172,9 +176,189 @@ TEST_CASE("iter") {
             CHECK_THROWS_AS(p4[1], y3c::internal::ub_invalid_iter);
             CHECK_THROWS_AS(p4--, y3c::internal::ub_invalid_iter);
         }
+        SUBCASE("multiple updates") {
+            // 無効化はイテレータが次に使われた時にまとめて判定される
+            life_->update(&array[0], &array[4], &array[3]);
+            CHECK_EQ(unwrap(p += 2), &array[3]);
+            CHECK_EQ(p->val, 400);
+            life_->update(&array[0], &array[5]);
+            CHECK_EQ(p->val, 400);
+            auto q = p0 + 4;
+            life_->update(&array[0], &array[5], &array[3]);
+            CHECK_EQ(p0->val, 100);
+            CHECK_THROWS_AS(p->val, y3c::internal::ub_invalid_iter);
+            CHECK_THROWS_AS(q->val, y3c::internal::ub_invalid_iter);
+            CHECK_THROWS_AS(*p4, y3c::internal::ub_invalid_iter);
+        }
+        SUBCASE("shrink and grow") {
+            life_->update(&array[1], &array[4]);
+            life_->update(&array[1], &array[5]);
+            life_->update(&array[1], &array[5], &array[2]);
+            CHECK_EQ(p->val, 200);
+            CHECK_THROWS_AS(*p0, y3c::internal::ub_invalid_iter);
+            CHECK_THROWS_AS(*p4, y3c::internal::ub_invalid_iter);
+        }
     }
 
     if (life_) {
         delete life_;
     }
 }
+
+TEST_CASE("iter without type name") {
+    y3c::internal::throw_on_terminate = true;
+
+    // 型名を持たないlifeのイテレータでも、チェックが成功する場合は
+    // 型名を取得しない
+    A array[3] = {100, 200, 300};
+    y3c::internal::life life_(&array[0], &array[3]);
+    y3c::internal::contiguous_iterator<A> p(&array[0], life_.observer());
+    ++p;
+    CHECK_EQ(p->val, 200);
+    CHECK_EQ((p + 1)->val, 300);
+    CHECK_THROWS_AS(p + 3, y3c::internal::ub_iter_after_end);
+    CHECK_THROWS_AS(*(p + 2), y3c::internal::ub_out_of_range);
+}
+
+TEST_CASE("iter reallocate") {
+    y3c::internal::throw_on_terminate = true;
+
+    A array[4] = {100, 200, 300, 400};
+    A array2[4] = {500, 600, 700, 800};
+    y3c::internal::life life_(&array[0], &array[4], &iter_name);
+    {
+        y3c::internal::contiguous_iterator<A> p(&array[1], life_.observer());
+        CHECK_EQ(p->val, 200);
+    }
+    // observerが残っていない状態での再割り当て
+    life_.update(&array2[0], &array2[4]);
+    y3c::internal::contiguous_iterator<A> q(&array2[1], life_.observer());
+    CHECK(life_ == q.get_observer_());
+    CHECK_EQ(q->val, 600);
+    CHECK_EQ((q + 2)->val, 800);
+    CHECK_THROWS_AS(q + 4, y3c::internal::ub_iter_after_end);
+
+    // observerが残っている状態での再割り当て
+    life_.update(&array[0], &array[4]);
+    CHECK(life_ != q.get_observer_());
+    CHECK_THROWS_AS(*q, y3c::internal::ub_access_deleted);
+    CHECK_THROWS_AS(q + 1, y3c::internal::ub_invalid_iter);
+}
+
+TEST_CASE("iter reset") {
+    y3c::internal::throw_on_terminate = true;
+
+    A array[4] = {100, 200, 300, 400};
+    y3c::internal::life life_(&array[0], &array[4], &iter_name);
+    {
+        y3c::internal::contiguous_iterator<A> p(&array[1], life_.observer());
+        life_.update(&array[0], &array[3], &array[1]);
+        CHECK_EQ(p.get_observer_().invalidations_size(), 1);
+        CHECK_THROWS_AS(*p, y3c::internal::ub_invalid_iter);
+    }
+    // observerが残っていない状態での更新では、以前の無効化の記録は残らない
+    life_.update(&array[0], &array[4]);
+    y3c::internal::contiguous_iterator<A> q(&array[1], life_.observer());
+    CHECK_EQ(q.get_observer_().invalidations_size(), 0);
+    CHECK_EQ(q->val, 200);
+    CHECK_EQ((q + 2)->val, 400);
+}
+
+TEST_CASE("iter sampling") {
+    y3c::internal::throw_on_terminate = true;
+    y3c::internal::check_sample_interval = 3;
+
+    A array[5] = {100, 200, 300, 400, 500};
+    y3c::internal::life life_(&array[0], &array[5], &iter_name);
+    y3c::internal::contiguous_iterator<A> p0(&array[0], life_.observer());
+    y3c::internal::contiguous_iterator<A> p4(&array[4], life_.observer());
+
+    SUBCASE("skipped checks") {
+        life_.update(&array[0], &array[5], &array[3]);
+        int thrown = 0;
+        for (int i = 0; i < 6; i++) {
+            try {
+                (void)p4->val;
+            } catch (const y3c::internal::ub_invalid_iter &) {
+                thrown++;
+            }
+        }
+        CHECK_EQ(thrown, 2);
+    }
+    SUBCASE("no false reports") {
+        // 有効なイテレータを移動した後に
+        // 移動先の位置で古い無効化を判定しないこと
+        auto p = p0 + 1;
+        life_.update(&array[0], &array[5], &array[3]);
+        for (int i = 0; i < 6; i++) {
+            p += 2;
+            CHECK_EQ(p->val, 400);
+            p -= 2;
+            CHECK_EQ(p->val, 200);
+        }
+    }
+
+    y3c::internal::check_sample_interval = 1;
+}
+
+TEST_CASE("reverse iter") {
+    y3c::internal::throw_on_terminate = true;
+
+    y3c::vector<A> v = {100, 200, 300, 400};
+    auto r = v.rbegin();
+    CHECK(r.base() == v.end());
+    CHECK(v.rend().base() == v.begin());
+    CHECK_EQ(v.rend() - v.rbegin(), 4);
+    CHECK_EQ(unwrap(*r).val, 400);
+    CHECK_EQ(r->val, 400);
+    CHECK_EQ(unwrap(r[3]).val, 100);
+    CHECK_EQ((r + 1)->val, 300);
+    CHECK_EQ((v.rend() - 1)->val, 100);
+    CHECK(r < r + 1);
+    CHECK(r + 4 == v.rend());
+
+    int sum = 0;
+    for (auto it = v.crbegin(); it != v.crend(); ++it) {
+        sum = sum * 10 + it->val / 100;
+    }
+    CHECK_EQ(sum, 4321);
+    y3c::vector<A>::const_reverse_iterator cr = r;
+    CHECK_EQ(cr->val, 400);
+
+    SUBCASE("out of range") {
+        CHECK_THROWS_AS(*v.rend(), y3c::internal::ub_out_of_range);
+        CHECK_THROWS_AS(r[4], y3c::internal::ub_out_of_range);
+        CHECK_THROWS_AS(r[5], y3c::internal::ub_iter_after_end);
+        CHECK_THROWS_AS(r + 5, y3c::internal::ub_iter_after_end);
+        CHECK_THROWS_AS(r - 1, y3c::internal::ub_iter_before_begin);
+        CHECK_THROWS_AS(--r, y3c::internal::ub_iter_before_begin);
+        auto e = v.rend();
+        CHECK_THROWS_AS(e++, y3c::internal::ub_iter_after_end);
+    }
+    SUBCASE("invalidate") {
+        auto r2 = r + 2;
+        v.pop_back();
+        CHECK_THROWS_AS(*r, y3c::internal::ub_invalid_iter);
+        CHECK_THROWS_AS(++r, y3c::internal::ub_invalid_iter);
+        CHECK_EQ(r2->val, 200);
+        CHECK_EQ((r2 + 1)->val, 100);
+        v.clear();
+        CHECK_THROWS_AS(*r2, y3c::internal::ub_access_deleted);
+    }
+    SUBCASE("array") {
+        y3c::array<A, 3> a = {1, 2, 3};
+        CHECK_EQ(a.rbegin()->val, 3);
+        CHECK_EQ((a.crend() - 1)->val, 1);
+        CHECK_THROWS_AS(*a.rend(), y3c::internal::ub_out_of_range);
+    }
+}
+
+TEST_CASE("iter size") {
+    // イテレータは値で渡されることが多いので大きくならないようにする
+    // (ポインタ、observer、validator、自身のライフタイム)
+    CHECK_LE(sizeof(y3c::internal::contiguous_iterator<int>),
+             4 * sizeof(void *));
+    CHECK_LE(sizeof(y3c::vector<int>::iterator), 4 * sizeof(void *));
+    CHECK_LE(sizeof(y3c::array<int, 3>::const_iterator), 4 * sizeof(void *));
+    CHECK_LE(sizeof(y3c::vector<int>::reverse_iterator), 4 * sizeof(void *));
+}
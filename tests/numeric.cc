@@ -0,0 +1,82 @@
+#include <y3c/numeric.h>
+#include <y3c/vector.h>
+#include <y3c/array.h>
+#include <y3c/wrap.h>
+#include <functional>
+
+#ifdef Y3C_DOCTEST_NESTED_HEADER
+#include <doctest/doctest.h>
+#else
+#include <doctest.h>
+#endif
+
+TEST_CASE("numeric") {
+    y3c::internal::throw_on_terminate = true;
+
+    y3c::vector<int> v = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    y3c::array<int, 9> a = {9, 8, 7, 6, 5, 4, 3, 2, 1};
+    y3c::wrap<int[9]> w = {1, 1, 1, 1, 1, 1, 1, 1, 1};
+    y3c::ptr<int> wp = w;
+
+    SUBCASE("accumulate") {
+        CHECK_EQ(y3c::accumulate(v.begin(), v.end(), 0), 45);
+        CHECK_EQ(y3c::accumulate(v.cbegin() + 1, v.cend(), 0), 44);
+        CHECK_EQ(y3c::accumulate(a.begin(), a.end(), 0), 45);
+        CHECK_EQ(y3c::accumulate(wp, wp + 9, 0), 9);
+        CHECK_EQ(y3c::accumulate(v.begin(), v.begin() + 4, 1,
+                                 std::multiplies<int>()),
+                 24);
+        y3c::vector<int> e;
+        CHECK_EQ(y3c::accumulate(e.begin(), e.end(), 3), 3);
+    }
+    SUBCASE("inner_product") {
+        CHECK_EQ(y3c::inner_product(v.begin(), v.end(), a.begin(), 0), 165);
+        CHECK_EQ(y3c::inner_product(v.begin(), v.end(), wp, 0), 45);
+        CHECK_EQ(y3c::inner_product(v.begin(), v.begin() + 3, a.begin(), 0,
+                                    std::plus<int>(), std::plus<int>()),
+                 30);
+        CHECK_THROWS_AS(
+            y3c::inner_product(v.begin(), v.end(), a.begin() + 1, 0),
+            y3c::internal::ub_iter_after_end);
+    }
+    SUBCASE("transform_reduce") {
+        CHECK_EQ(y3c::transform_reduce(v.begin(), v.end(), a.begin(), 0), 165);
+        for (int n = 0; n <= 9; n++) {
+            CHECK_EQ(y3c::transform_reduce(v.begin(), v.begin() + n, 0,
+                                           std::plus<int>(),
+                                           [](int x) { return x * x; }),
+                     n * (n + 1) * (2 * n + 1) / 6);
+        }
+        CHECK_EQ(y3c::transform_reduce(v.begin(), v.end(), a.begin(), 0,
+                                       std::plus<int>(), std::plus<int>()),
+                 90);
+    }
+    SUBCASE("partial_sum") {
+        y3c::vector<int> out(9);
+        auto it = y3c::partial_sum(v.begin(), v.end(), out.begin());
+        CHECK(it == out.end());
+        CHECK_EQ(unwrap(out[8]), 45);
+        CHECK_EQ(unwrap(out[2]), 6);
+        y3c::partial_sum(v.begin(), v.begin() + 4, wp, std::multiplies<int>());
+        CHECK_EQ(unwrap(w[3]), 24);
+        CHECK_THROWS_AS(y3c::partial_sum(v.begin(), v.end(), out.begin() + 1),
+                        y3c::internal::ub_iter_after_end);
+    }
+    SUBCASE("iota") {
+        y3c::iota(v.begin(), v.end(), 10);
+        CHECK_EQ(unwrap(v[0]), 10);
+        CHECK_EQ(unwrap(v[8]), 18);
+        y3c::iota(wp, wp + 9, 0);
+        CHECK_EQ(unwrap(w[8]), 8);
+    }
+    SUBCASE("invalid range") {
+        CHECK_THROWS_AS(y3c::accumulate(v.begin(), a.begin(), 0),
+                        y3c::internal::ub_wrong_iter);
+        CHECK_THROWS_AS(y3c::accumulate(wp, wp + 10, 0),
+                        y3c::internal::ub_out_of_range);
+        y3c::wrap<int[9]> w2;
+        y3c::ptr<int> wp2 = w2;
+        CHECK_THROWS_AS(y3c::accumulate(wp, wp2, 0),
+                        y3c::internal::ub_wrong_iter);
+    }
+}
@@ -0,0 +1,133 @@
+#include <y3c/parallel.h>
+#include <y3c/vector.h>
+#include <y3c/array.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef Y3C_DOCTEST_NESTED_HEADER
+#include <doctest/doctest.h>
+#else
+#include <doctest.h>
+#endif
+
+TEST_CASE("parallel") {
+    y3c::internal::throw_on_terminate = true;
+
+    // 複数のチャンクに分かれる大きさ
+    const int n = 100000;
+    std::vector<int> shuffled(n);
+    for (int i = 0; i < n; i++) {
+        shuffled[i] = static_cast<int>((i * 7919L) % n);
+    }
+    y3c::vector<int> v(shuffled.begin(), shuffled.end());
+
+    SUBCASE("for_each") {
+        y3c::parallel::for_each(v.begin(), v.end(), [](int &x) { x *= 2; });
+        bool ok = true;
+        for (int i = 0; i < n; i++) {
+            ok = ok && unwrap(v[i]) == shuffled[i] * 2;
+        }
+        CHECK(ok);
+        std::atomic<int> count(0);
+        y3c::parallel::for_each(v.begin() + 10, v.end() - 10,
+                                [&](int &) { ++count; });
+        CHECK_EQ(count.load(), n - 20);
+    }
+    SUBCASE("transform") {
+        y3c::vector<long> out(n);
+        auto it = y3c::parallel::transform(v.begin(), v.end(), out.begin(),
+                                           [](int x) { return x * 3L; });
+        CHECK(it == out.end());
+        bool ok = true;
+        for (int i = 0; i < n; i++) {
+            ok = ok && unwrap(out[i]) == shuffled[i] * 3L;
+        }
+        CHECK(ok);
+        y3c::vector<long> small(n - 1);
+        CHECK_THROWS_AS(y3c::parallel::transform(v.begin(), v.end(),
+                                                 small.begin(),
+                                                 [](int x) { return x; }),
+                        y3c::internal::ub_iter_after_end);
+    }
+    SUBCASE("sort") {
+        y3c::parallel::sort(v.begin(), v.end());
+        bool ok = true;
+        for (int i = 0; i < n; i++) {
+            ok = ok && unwrap(v[i]) == i;
+        }
+        CHECK(ok);
+        y3c::parallel::sort(v.begin(), v.end(), std::greater<int>());
+        CHECK_EQ(unwrap(v[0]), n - 1);
+        CHECK_EQ(unwrap(v[n - 1]), 0);
+        y3c::array<int, 5> a = {3, 1, 4, 1, 5};
+        y3c::parallel::sort(a.begin(), a.end());
+        CHECK_EQ(unwrap(a[0]), 1);
+        CHECK_EQ(unwrap(a[4]), 5);
+    }
+    SUBCASE("reduce") {
+        CHECK_EQ(y3c::parallel::reduce(v.begin(), v.end(), 0L),
+                 static_cast<long>(n) * (n - 1) / 2);
+        auto max = [](int a, int b) { return std::max(a, b); };
+        CHECK_EQ(y3c::parallel::reduce(v.begin(), v.end(), 0, max), n - 1);
+        CHECK_EQ(y3c::parallel::reduce(v.begin(), v.begin(), 5L), 5L);
+    }
+    SUBCASE("invalid range") {
+        y3c::vector<int> w(n);
+        CHECK_THROWS_AS(
+            y3c::parallel::for_each(v.begin(), w.end(), [](int &) {}),
+            y3c::internal::ub_wrong_iter);
+        CHECK_THROWS_AS(y3c::parallel::reduce(v.end(), v.begin(), 0),
+                        y3c::internal::ub_out_of_range);
+    }
+    SUBCASE("exception in function") {
+        auto f = [](int &x) {
+            if (x == 12345) {
+                throw std::runtime_error("");
+            }
+        };
+        CHECK_THROWS_AS(y3c::parallel::for_each(v.begin(), v.end(), f),
+                        std::runtime_error);
+    }
+    SUBCASE("nested") {
+        // 内側の呼び出しはチャンクを処理しているスレッドでその場で実行される
+        // (呼び出し元のスレッドで実行されるチャンクも含む)
+        const int chunk = 2048, chunks = 16;
+        y3c::vector<int> outer(chunk * chunks);
+        for (int i = 0; i < chunk * chunks; i++) {
+            outer[i] = i;
+        }
+        std::atomic<long> sum(0);
+        std::atomic<bool> caller_ran(false);
+        std::thread::id caller = std::this_thread::get_id();
+        y3c::parallel::for_each(outer.begin(), outer.end(), [&](int &x) {
+            if (x % chunk != 0) {
+                return;
+            }
+            if (std::this_thread::get_id() != caller) {
+                // 呼び出し元のスレッドにもチャンクが回るようにする
+                while (!caller_ran.load()) {
+                    std::this_thread::yield();
+                }
+            }
+            sum += y3c::parallel::reduce(v.begin(), v.begin() + 8192, 0L);
+            caller_ran.store(true);
+        });
+        CHECK_EQ(sum.load(), chunks * y3c::parallel::reduce(
+                                          v.begin(), v.begin() + 8192, 0L));
+    }
+    SUBCASE("modified while running") {
+        // 1チャンクで呼び出し元のスレッドで実行される大きさ
+        y3c::vector<int> w = {1, 2, 3};
+        auto f = [&](int &x) {
+            if (x == 3) {
+                w.pop_back();
+            }
+        };
+        CHECK_THROWS_AS(y3c::parallel::for_each(w.begin(), w.end(), f),
+                        y3c::internal::ub_invalid_iter);
+    }
+}
@@ -0,0 +1,72 @@
+// このテストはパススルーモードでビルドする
+#define Y3C_PASSTHROUGH 1
+#include <y3c/vector>
+#include <y3c/array>
+#include <y3c/memory>
+#include <y3c/wrap>
+#include <type_traits>
+
+#ifdef Y3C_DOCTEST_NESTED_HEADER
+#include <doctest/doctest.h>
+#else
+#include <doctest.h>
+#endif
+
+// 型がstd::のものと同じなので、レイアウトも生成されるコードも同じになる
+static_assert(std::is_same<y3c::vector<int>, std::vector<int>>::value, "");
+static_assert(std::is_same<y3c::vector<int>::iterator,
+                           std::vector<int>::iterator>::value,
+              "");
+static_assert(std::is_same<y3c::array<int, 3>, std::array<int, 3>>::value,
+              "");
+static_assert(
+    std::is_same<y3c::shared_ptr<int>, std::shared_ptr<int>>::value, "");
+static_assert(std::is_same<y3c::wrap<int>, int>::value, "");
+static_assert(std::is_same<y3c::wrap<int[3]>, int[3]>::value, "");
+static_assert(std::is_same<y3c::wrap_ref<int>, int &>::value, "");
+static_assert(std::is_same<y3c::const_wrap_ref<int>, const int &>::value,
+              "");
+static_assert(std::is_same<y3c::ptr<int>, int *>::value, "");
+static_assert(std::is_same<y3c::const_ptr<int>, const int *>::value, "");
+static_assert(std::is_same<y3c::ptr_const<int>, int *const>::value, "");
+
+TEST_CASE("passthrough sizeof") {
+    CHECK_EQ(sizeof(y3c::vector<int>), sizeof(std::vector<int>));
+    CHECK_EQ(sizeof(y3c::vector<int>::iterator),
+             sizeof(std::vector<int>::iterator));
+    CHECK_EQ(sizeof(y3c::array<int, 3>), sizeof(std::array<int, 3>));
+    CHECK_EQ(sizeof(y3c::shared_ptr<int>), sizeof(std::shared_ptr<int>));
+    CHECK_EQ(sizeof(y3c::wrap<int>), sizeof(int));
+    CHECK_EQ(sizeof(y3c::ptr<int>), sizeof(int *));
+}
+
+TEST_CASE("passthrough unwrap") {
+    y3c::vector<int> v = {1, 2, 3};
+    std::vector<int> &sv = y3c::unwrap(v);
+    CHECK_EQ(&sv, &v);
+    CHECK_EQ(&unwrap(v), &v);
+    y3c::wrap_ref<int> r = v[1];
+    CHECK_EQ(&y3c::unwrap(r), &v[1]);
+    CHECK_EQ(y3c::unwrap(v.begin() + 1), v.begin() + 1);
+
+    int sum = 0;
+    for (int &x : y3c::range(v)) {
+        sum += x;
+    }
+    CHECK_EQ(sum, 6);
+    {
+        auto tx = y3c::batch(v);
+        v.push_back(4);
+    }
+    CHECK_EQ(v.size(), 4);
+    CHECK_EQ(y3c::erase_if(v, [](int x) { return x % 2 == 0; }), 2);
+    CHECK_EQ(y3c::erase(v, 3), 1);
+    CHECK_EQ(v.size(), 1);
+
+    y3c::shared_ptr<int> p = y3c::make_shared<int>(5);
+    CHECK_EQ(*y3c::unwrap(p), 5);
+
+    y3c::wrap<int> i = 3;
+    y3c::ptr<int> ip = &i;
+    CHECK_EQ(y3c::unwrap(ip), &i);
+}
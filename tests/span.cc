@@ -0,0 +1,171 @@
+#include <y3c/span.h>
+#include <y3c/vector.h>
+#include <y3c/array.h>
+#include <y3c/wrap.h>
+#include <type_traits>
+#include <algorithm>
+
+#ifdef Y3C_DOCTEST_NESTED_HEADER
+#include <doctest/doctest.h>
+#else
+#include <doctest.h>
+#endif
+
+static_assert(std::is_constructible<y3c::span<int>, y3c::vector<int> &>::value,
+              "");
+static_assert(
+    !std::is_constructible<y3c::span<int>, const y3c::vector<int> &>::value,
+    "");
+static_assert(
+    std::is_constructible<y3c::span<const int>,
+                          const y3c::vector<int> &>::value,
+    "");
+static_assert(
+    !std::is_constructible<y3c::span<int>, y3c::vector<long> &>::value, "");
+static_assert(
+    std::is_convertible<y3c::span<int>, y3c::span<const int>>::value, "");
+static_assert(
+    !std::is_convertible<y3c::span<const int>, y3c::span<int>>::value, "");
+
+static int sum(y3c::span<const int> s) {
+    int total = 0;
+    for (const int &x : y3c::range(s)) {
+        total += x;
+    }
+    return total;
+}
+
+TEST_CASE("span") {
+    y3c::internal::throw_on_terminate = true;
+
+    y3c::vector<int> v = {1, 2, 3, 4, 5};
+    y3c::array<int, 3> a = {10, 20, 30};
+    y3c::wrap<int[4]> w = {100, 200, 300, 400};
+
+    SUBCASE("empty") {
+        y3c::span<int> s;
+        CHECK(s.empty());
+        CHECK_EQ(s.size(), 0);
+        CHECK(s.begin() == s.end());
+        CHECK_EQ(sum(s), 0);
+        CHECK_THROWS_AS(s[0], y3c::internal::ub_out_of_range);
+        CHECK_THROWS_AS(s.front(), y3c::internal::ub_out_of_range);
+    }
+    SUBCASE("from containers") {
+        y3c::span<int> sv = v;
+        CHECK_EQ(sv.size(), 5);
+        CHECK_EQ(sv.size_bytes(), 5 * sizeof(int));
+        CHECK_EQ(unwrap(sv[4]), 5);
+        sv[0] = 7;
+        CHECK_EQ(unwrap(v[0]), 7);
+        CHECK_EQ(sum(v), 21);
+        CHECK_EQ(sum(a), 60);
+        CHECK_EQ(sum(w), 1000);
+        const y3c::vector<int> &cv = v;
+        y3c::span<const int> scv = cv;
+        CHECK_EQ(unwrap(scv.back()), 5);
+        y3c::span<int> sw(w);
+        CHECK_EQ(unwrap(sw.front()), 100);
+    }
+    SUBCASE("from pointer") {
+        y3c::ptr<int> p = w;
+        y3c::span<int> s(p + 1, 3);
+        CHECK_EQ(unwrap(s[0]), 200);
+        CHECK_EQ(unwrap(s.back()), 400);
+        CHECK_THROWS_AS(y3c::span<int>(p + 1, 4),
+                        y3c::internal::ub_out_of_range);
+        CHECK_THROWS_AS(y3c::span<int>(y3c::ptr<int>(), 1),
+                        y3c::internal::ub_access_nullptr);
+        y3c::span<int> sv(v.data() + 2, 3);
+        CHECK_EQ(unwrap(sv.front()), 3);
+    }
+    SUBCASE("subspan") {
+        y3c::span<int> s = v;
+        CHECK_EQ(unwrap(s.first(2).back()), 2);
+        CHECK_EQ(unwrap(s.last(2).front()), 4);
+        CHECK_EQ(unwrap(s.subspan(1, 3).back()), 4);
+        CHECK_EQ(s.subspan(2).size(), 3);
+        CHECK_EQ(s.subspan(5).size(), 0);
+        CHECK_EQ(sum(s.subspan(1, 2)), 5);
+        CHECK_THROWS_AS(s.first(6), y3c::internal::ub_out_of_range);
+        CHECK_THROWS_AS(s.last(6), y3c::internal::ub_out_of_range);
+        CHECK_THROWS_AS(s.subspan(6), y3c::internal::ub_out_of_range);
+        CHECK_THROWS_AS(s.subspan(3, 3), y3c::internal::ub_out_of_range);
+        CHECK_THROWS_AS(s.subspan(1, 2)[2], y3c::internal::ub_out_of_range);
+    }
+    SUBCASE("iterator") {
+        y3c::span<int> s = v;
+        int total = 0;
+        for (auto it = s.begin() + 1; it != s.end(); ++it) {
+            total += unwrap(*it);
+        }
+        CHECK_EQ(total, 14);
+        CHECK_EQ(s.end() - s.begin(), 5);
+        CHECK_THROWS_AS(*s.end(), y3c::internal::ub_out_of_range);
+        y3c::span<const int> cs = s;
+        y3c::span<const int>::iterator cit = s.begin();
+        CHECK(cit == cs.begin());
+        CHECK_EQ(unwrap(cit[2]), 3);
+        CHECK_EQ(std::count_if(cs.begin(), cs.end(),
+                               [](y3c::const_wrap_ref<int> x) {
+                                   return unwrap(x) > 2;
+                               }),
+                 3);
+    }
+    SUBCASE("iterator of wrap array") {
+        y3c::span<int> s = w;
+        int total = 0;
+        for (auto it = s.begin(); it != s.end(); ++it) {
+            total += unwrap(*it);
+        }
+        CHECK_EQ(total, 1000);
+        total = 0;
+        for (int x : s) {
+            total += x;
+        }
+        CHECK_EQ(total, 1000);
+        CHECK_THROWS_AS(s.end() + 1, y3c::internal::ub_iter_after_end);
+        CHECK_THROWS_AS(s.begin() - 1, y3c::internal::ub_iter_before_begin);
+    }
+    SUBCASE("iterator of empty span") {
+        y3c::span<int> s;
+        int count = 0;
+        for (auto it = s.begin(); it != s.end(); ++it) {
+            count++;
+        }
+        for (int x : s) {
+            count += x;
+        }
+        CHECK_EQ(count, 0);
+        CHECK_EQ(s.end() - s.begin(), 0);
+        CHECK_THROWS_AS(*s.begin(), y3c::internal::ub_out_of_range);
+        CHECK_THROWS_AS(++s.begin(), y3c::internal::ub_iter_after_end);
+    }
+    SUBCASE("iterator bounded by span") {
+        // 参照先のvectorの範囲内でも、spanの範囲外には出られない
+        y3c::span<int> s = v;
+        auto it = s.first(2).end();
+        CHECK_THROWS_AS(*it, y3c::internal::ub_out_of_range);
+        CHECK_THROWS_AS(it[0], y3c::internal::ub_out_of_range);
+        CHECK_THROWS_AS(++it, y3c::internal::ub_iter_after_end);
+        CHECK_THROWS_AS(it + 1, y3c::internal::ub_iter_after_end);
+        auto it2 = s.last(2).begin();
+        CHECK_EQ(unwrap(*it2), 4);
+        CHECK_THROWS_AS(--it2, y3c::internal::ub_iter_before_begin);
+        CHECK_THROWS_AS(it2[-1], y3c::internal::ub_out_of_range);
+        v.resize(4);
+        CHECK_THROWS_AS(it2[1], y3c::internal::ub_out_of_range);
+    }
+    SUBCASE("container modified") {
+        y3c::span<int> s = v;
+        v.pop_back();
+        CHECK_EQ(unwrap(s[3]), 4);
+        CHECK_THROWS_AS(s[4], y3c::internal::ub_out_of_range);
+        y3c::span<int> sw;
+        {
+            y3c::wrap<int[4]> w2 = {1, 2, 3, 4};
+            sw = w2;
+        }
+        CHECK_THROWS_AS(sw[0], y3c::internal::ub_access_deleted);
+    }
+}
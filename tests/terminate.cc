@@ -22,4 +22,38 @@ TEST_CASE("terminate") {
                     y3c::internal::ub_iter_after_end);
     CHECK_THROWS_AS(y3c::internal::terminate_ub_iter_before_begin(""),
                     y3c::internal::ub_iter_before_begin);
+    CHECK_THROWS_AS(y3c::internal::terminate_ub_modify_pinned(""),
+                    y3c::internal::ub_modify_pinned);
+}
+
+const std::string &hoge_name() {
+    static std::string name = "hoge";
+    return name;
+}
+
+TEST_CASE("func_name") {
+    y3c::internal::throw_on_terminate = true;
+
+    static constexpr y3c::internal::func_name func{&hoge_name, "::fuga()"};
+    static constexpr y3c::internal::func_name func2{"cast from ", &hoge_name,
+                                                    " to reference"};
+    CHECK_EQ(func.str(), "hoge::fuga()");
+    CHECK_EQ(func2.str(), "cast from hoge to reference");
+
+    // 型名をオブジェクトから取得する場合、str() まで呼ばれない
+    static int calls = 0;
+    struct named {
+        std::string name;
+        static const std::string &name_of(const void *self) {
+            calls++;
+            return static_cast<const named *>(self)->name;
+        }
+    };
+    named obj{"piyo"};
+    y3c::internal::func_name func3{"", &named::name_of, &obj, "::fuga()"};
+    CHECK_EQ(calls, 0);
+    CHECK_EQ(func3.str(), "piyo::fuga()");
+    CHECK_EQ(calls, 1);
+    CHECK_THROWS_AS(y3c::internal::terminate_ub_out_of_range(func, 0, 0),
+                    y3c::internal::ub_out_of_range);
 }
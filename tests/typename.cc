@@ -19,3 +19,9 @@ TEST_CASE("typename") {
     CHECK_EQ(y3c::internal::get_type_name<A>(), "A");
     CHECK_EQ(y3c::internal::get_type_name<B<int>>(), "B<int>");
 }
+
+#if Y3C_CONSTEXPR_TYPE_NAME
+static_assert(y3c::internal::get_type_name_view<int>() == "int", "");
+static_assert(y3c::internal::get_type_name_view<A>() == "A", "");
+static_assert(y3c::internal::get_type_name_view<B<A>>() == "B<A>", "");
+#endif
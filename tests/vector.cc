@@ -1,5 +1,6 @@
 #include <y3c/vector.h>
 #include <y3c/array.h>
+#include <thread>
 
 #ifdef Y3C_DOCTEST_NESTED_HEADER
 #include <doctest/doctest.h>
@@ -134,6 +135,11 @@ TEST_CASE("vector") {
                 CHECK_EQ(unwrap(b2), unwrap(a.data()) + 2);
                 CHECK_EQ(unwrap(*b0).val, 300);
                 CHECK_EQ(unwrap(*(b2 - 1)).val, 400);
+                // ムーブ元も空のvectorとして使える
+                b.push_back(500);
+                CHECK_EQ(unwrap(b[0]).val, 500);
+                CHECK_EQ(unwrap(*b0).val, 300);
+                CHECK_THROWS_AS(b.erase(b0), y3c::internal::ub_wrong_iter);
             }
             SUBCASE("base copy") { a = c; }
             SUBCASE("base move") { a = std::move(c); }
@@ -354,3 +360,510 @@ TEST_CASE("vector") {
         CHECK_EQ(unwrap(b)[1].val, 200);
     }
 }
+
+TEST_CASE("vector range") {
+    y3c::internal::throw_on_terminate = true;
+
+    y3c::vector<int> v = {1, 2, 3, 4, 5};
+    SUBCASE("iterate") {
+        int sum = 0;
+        for (int &x : y3c::range(v)) {
+            x *= 2;
+            sum += x;
+        }
+        CHECK_EQ(sum, 30);
+        const y3c::vector<int> &cv = v;
+        sum = 0;
+        for (const int &x : y3c::range(cv)) {
+            sum += x;
+        }
+        CHECK_EQ(sum, 30);
+        y3c::vector<int> e;
+        int count = 0;
+        for (int &x : y3c::range(e)) {
+            (void)x;
+            count++;
+        }
+        CHECK_EQ(count, 0);
+    }
+    SUBCASE("element assignment is not a mutation") {
+        for (int &x : y3c::range(v)) {
+            v[0] = x;
+        }
+        CHECK_EQ(unwrap(v[0]), 5);
+    }
+    SUBCASE("reallocation") {
+        auto loop = [&] {
+            for (int &x : y3c::range(v)) {
+                v.push_back(x);
+            }
+        };
+        v.shrink_to_fit();
+        CHECK_THROWS_AS(loop(), y3c::internal::ub_invalid_iter);
+    }
+    SUBCASE("erase") {
+        auto loop = [&] {
+            for (int &x : y3c::range(v)) {
+                if (x == 2) {
+                    v.erase(v.begin());
+                }
+            }
+        };
+        CHECK_THROWS_AS(loop(), y3c::internal::ub_invalid_iter);
+    }
+    SUBCASE("pop_back at the last element") {
+        // 終端に達した後は無効化されていても問題ない
+        int count = 0;
+        for (int &x : y3c::range(v)) {
+            count++;
+            if (x == 5) {
+                v.pop_back();
+            }
+        }
+        CHECK_EQ(count, 5);
+    }
+}
+
+TEST_CASE("vector back_inserter") {
+    y3c::internal::throw_on_terminate = true;
+
+    y3c::vector<int> a = {1, 2};
+    a.reserve(10);
+    auto first = a.begin();
+    auto end = a.end();
+    SUBCASE("push_back") {
+        auto it = y3c::back_inserter(a);
+        *it++ = 3;
+        *it++ = 4;
+        CHECK(unwrap(a) == std::vector<int>{1, 2, 3, 4});
+        CHECK_EQ(unwrap(*first), 1);
+        CHECK_THROWS_AS(*end, y3c::internal::ub_invalid_iter);
+    }
+    static constexpr y3c::internal::func_name func{
+        &y3c::internal::get_type_name<y3c::vector<int>>, "::append_()"};
+    SUBCASE("append_") {
+        std::vector<int> src = {3, 4, 5};
+        a.append_(src.begin(), src.end(), func);
+        CHECK(unwrap(a) == std::vector<int>{1, 2, 3, 4, 5});
+        CHECK_EQ(unwrap(*first), 1);
+        CHECK_THROWS_AS(*end, y3c::internal::ub_invalid_iter);
+        CHECK_LE(first.get_observer_().invalidations_size(), 1);
+        std::vector<int> many(20, 0);
+        a.append_(many.begin(), many.end(), func);
+        CHECK_EQ(a.size(), 25);
+        CHECK_THROWS_AS(*first, y3c::internal::ub_access_deleted);
+    }
+    SUBCASE("append_ while pinned") {
+        auto p = a.pin();
+        std::vector<int> src = {3};
+        CHECK_THROWS_AS(a.append_(src.begin(), src.end(), func),
+                        y3c::internal::ub_modify_pinned);
+        CHECK_THROWS_AS(a.append_range(src), y3c::internal::ub_modify_pinned);
+        CHECK_EQ(a.size(), 2);
+    }
+}
+
+TEST_CASE("vector range api") {
+    y3c::internal::throw_on_terminate = true;
+
+    y3c::vector<int> a = {1, 2, 3, 4, 5, 6};
+    a.reserve(100);
+    auto first = a.begin();
+    auto third = a.begin() + 2;
+    auto end = a.end();
+    SUBCASE("append_range") {
+        y3c::vector<int> b = {7, 8};
+        a.append_range(b);
+        std::vector<int> c = {9};
+        a.append_range(c);
+        CHECK(unwrap(a) == std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9});
+        CHECK_EQ(unwrap(*third), 3);
+        CHECK_THROWS_AS(*end, y3c::internal::ub_invalid_iter);
+    }
+    SUBCASE("insert_range") {
+        y3c::array<int, 2> b = {7, 8};
+        auto it = a.insert_range(a.begin() + 1, b);
+        CHECK_EQ(unwrap(*it), 7);
+        CHECK(unwrap(a) == std::vector<int>{1, 7, 8, 2, 3, 4, 5, 6});
+        CHECK_EQ(unwrap(*first), 1);
+        CHECK_THROWS_AS(*third, y3c::internal::ub_invalid_iter);
+        y3c::vector<int> other;
+        CHECK_THROWS_AS(a.insert_range(other.begin(), b),
+                        y3c::internal::ub_wrong_iter);
+    }
+    SUBCASE("assign_range") {
+        int b[] = {7, 8};
+        a.assign_range(b);
+        CHECK(unwrap(a) == std::vector<int>{7, 8});
+        CHECK_THROWS_AS(*first, y3c::internal::ub_access_deleted);
+    }
+    SUBCASE("erase_if") {
+        auto n = y3c::erase_if(a, [](int x) { return x == 2 || x == 5; });
+        CHECK_EQ(n, 2);
+        CHECK(unwrap(a) == std::vector<int>{1, 3, 4, 6});
+        CHECK_EQ(unwrap(*first), 1);
+        CHECK_THROWS_AS(*third, y3c::internal::ub_invalid_iter);
+        CHECK_LE(first.get_observer_().invalidations_size(), 1);
+        CHECK_EQ(y3c::erase(a, 4), 1);
+        CHECK_EQ(y3c::erase(a, 5), 0);
+        CHECK(unwrap(a) == std::vector<int>{1, 3, 6});
+    }
+    SUBCASE("insert count") {
+        std::string s = "abc";
+        y3c::vector<std::string> v;
+        v.insert(v.begin(), 2, s);
+        CHECK_EQ(s, "abc");
+        CHECK(unwrap(v) == std::vector<std::string>{"abc", "abc"});
+    }
+    SUBCASE("move from rvalue range") {
+        // ムーブしかできない要素でも右辺値の範囲からは追加できる
+        y3c::vector<std::unique_ptr<int>> v;
+        std::vector<std::unique_ptr<int>> src;
+        src.emplace_back(new int(1));
+        src.emplace_back(new int(2));
+        v.append_range(std::move(src));
+        CHECK_EQ(*unwrap(v[1]), 2);
+        CHECK(src[0] == nullptr);
+        src.resize(1);
+        src[0].reset(new int(0));
+        v.insert_range(v.begin(), std::move(src));
+        CHECK_EQ(*unwrap(v[0]), 0);
+        CHECK_EQ(v.size(), 3);
+        src[0].reset(new int(3));
+        v.assign_range(std::move(src));
+        CHECK_EQ(*unwrap(v[0]), 3);
+        CHECK_EQ(v.size(), 1);
+    }
+    SUBCASE("erase_if with throwing predicate") {
+        auto fourth = a.begin() + 3;
+        CHECK_THROWS_AS(y3c::erase_if(a,
+                                      [](int x) {
+                                          if (x == 4) {
+                                              throw std::runtime_error("");
+                                          }
+                                          return x == 2;
+                                      }),
+                        std::runtime_error);
+        CHECK_EQ(a.size(), 6);
+        CHECK_EQ(unwrap(*first), 1);
+        CHECK_THROWS_AS(*third, y3c::internal::ub_invalid_iter);
+        CHECK_THROWS_AS(*fourth, y3c::internal::ub_invalid_iter);
+    }
+}
+
+TEST_CASE("vector batch") {
+    y3c::internal::throw_on_terminate = true;
+
+    y3c::vector<int> a = {1, 2, 3, 4};
+    a.reserve(100);
+    auto first = a.begin();
+    auto third = a.begin() + 2;
+    auto fourth = a.begin() + 3;
+    auto end = a.end();
+    SUBCASE("push_back") {
+        {
+            auto tx = a.batch();
+            for (int i = 0; i < 50; i++) {
+                a.push_back(i);
+            }
+            a.emplace_back(50);
+            a.resize(60);
+            // 末尾への追加は1つの記録にまとまる
+            CHECK_LE(first.get_observer_().invalidations_size(), 1);
+            CHECK_THROWS_AS(*end, y3c::internal::ub_invalid_iter);
+            const y3c::vector<int> &ca = a;
+            CHECK_EQ(unwrap(ca[54]), 50);
+            CHECK_EQ(unwrap(*(ca.end() - 1)), 0);
+        }
+        CHECK_EQ(a.size(), 60);
+        CHECK_LE(first.get_observer_().invalidations_size(), 1);
+        CHECK_EQ(unwrap(*first), 1);
+        CHECK_EQ(unwrap(*fourth), 4);
+        CHECK_THROWS_AS(*end, y3c::internal::ub_invalid_iter);
+    }
+    SUBCASE("pop_back") {
+        y3c::vector<std::string> v = {"a", "b", "c"};
+        auto tx = v.batch();
+        v.push_back("d");
+        auto last = v.end() - 1;
+        y3c::wrap_ref<std::string> ref = v.back();
+        v.pop_back();
+        CHECK_THROWS_AS(*last, y3c::internal::ub_invalid_iter);
+        CHECK_THROWS_AS(unwrap(ref), y3c::internal::ub_out_of_range);
+        CHECK_THROWS_AS(static_cast<std::string &>(ref),
+                        y3c::internal::ub_out_of_range);
+        a.pop_back();
+        CHECK_THROWS_AS(*fourth, y3c::internal::ub_invalid_iter);
+        CHECK_EQ(unwrap(*third), 3);
+    }
+    SUBCASE("end moved inside") {
+        // batch() の外と同様、無効になったend()を動かしても有効にはならない
+        auto tx = a.batch();
+        a.push_back(5);
+        auto e = end;
+        CHECK_THROWS_AS(e -= 1, y3c::internal::ub_invalid_iter);
+        tx.commit();
+        CHECK_THROWS_AS(*end, y3c::internal::ub_invalid_iter);
+    }
+    SUBCASE("end taken inside") {
+        // 途中で取得したend()も、その後の追加で無効になる
+        auto inside_end = a.end();
+        {
+            auto tx = a.batch();
+            a.push_back(5);
+            inside_end = a.end();
+            a.push_back(6);
+            CHECK_THROWS_AS(*inside_end, y3c::internal::ub_invalid_iter);
+            a.push_back(7);
+        }
+        a.push_back(8);
+        CHECK_THROWS_AS(*inside_end, y3c::internal::ub_invalid_iter);
+        CHECK_THROWS_AS(a.insert(inside_end, 0),
+                        y3c::internal::ub_invalid_iter);
+        CHECK_EQ(a.size(), 8);
+    }
+    SUBCASE("iterators inside") {
+        auto tx = y3c::batch(a);
+        a.push_back(5);
+        auto it = a.begin() + 4;
+        CHECK_EQ(unwrap(*it), 5);
+        a.push_back(6);
+        CHECK_EQ(unwrap(*it), 5);
+        CHECK_THROWS_AS(*end, y3c::internal::ub_invalid_iter);
+        a.push_back(7);
+        a.erase(a.begin() + 1);
+        CHECK_EQ(unwrap(*first), 1);
+        CHECK_THROWS_AS(*third, y3c::internal::ub_invalid_iter);
+        CHECK_THROWS_AS(*it, y3c::internal::ub_invalid_iter);
+        a.pop_back();
+        tx.commit();
+        CHECK_THROWS_AS(*(a.begin() + 5), y3c::internal::ub_out_of_range);
+    }
+    SUBCASE("reallocate") {
+        auto tx = a.batch();
+        a.pop_back();
+        a.resize(200);
+        CHECK_THROWS_AS(*first, y3c::internal::ub_access_deleted);
+    }
+    SUBCASE("nested and moved") {
+        auto tx = a.batch();
+        {
+            auto inner = a.batch();
+            a.push_back(5);
+        }
+        y3c::vector<int> b = std::move(a);
+        CHECK_THROWS_AS(*end, y3c::internal::ub_invalid_iter);
+        CHECK_EQ(unwrap(*first), 1);
+        CHECK_EQ(b.size(), 5);
+    }
+}
+
+TEST_CASE("vector pin") {
+    y3c::internal::throw_on_terminate = true;
+
+    y3c::vector<int> a = {1, 2, 3};
+    a.reserve(10);
+    {
+        auto p = a.pin();
+        int sum = 0;
+        for (int &x : p) {
+            x *= 2;
+            sum += x;
+        }
+        CHECK_EQ(sum, 12);
+        CHECK_EQ(p[2], 6);
+        CHECK_EQ(p.size(), 3);
+        CHECK_THROWS_AS(p[3], y3c::internal::ub_out_of_range);
+        a[0] = 10;
+        CHECK_EQ(p[0], 10);
+
+        CHECK_THROWS_AS(a.push_back(4), y3c::internal::ub_modify_pinned);
+        CHECK_THROWS_AS(a.emplace_back(4), y3c::internal::ub_modify_pinned);
+        CHECK_THROWS_AS(a.insert(a.begin(), 4),
+                        y3c::internal::ub_modify_pinned);
+        CHECK_THROWS_AS(a.erase(a.begin()), y3c::internal::ub_modify_pinned);
+        CHECK_THROWS_AS(a.resize(5), y3c::internal::ub_modify_pinned);
+        CHECK_THROWS_AS(a.reserve(20), y3c::internal::ub_modify_pinned);
+        CHECK_THROWS_AS(a.pop_back(), y3c::internal::ub_modify_pinned);
+        CHECK_THROWS_AS(a.clear(), y3c::internal::ub_modify_pinned);
+        CHECK_THROWS_AS(a = {1}, y3c::internal::ub_modify_pinned);
+        CHECK_THROWS_AS(y3c::erase(a, 2), y3c::internal::ub_modify_pinned);
+        y3c::vector<int> b;
+        CHECK_THROWS_AS(a.swap(b), y3c::internal::ub_modify_pinned);
+        CHECK_THROWS_AS(b = std::move(a), y3c::internal::ub_modify_pinned);
+        CHECK(unwrap(a) == std::vector<int>{10, 4, 6});
+
+        const y3c::vector<int> &ca = a;
+        auto cp = ca.pin();
+        auto p2 = std::move(p);
+        CHECK_EQ(cp[1], 4);
+    }
+    a.push_back(4);
+    CHECK_EQ(a.size(), 4);
+
+    SUBCASE("destroy after unpin") {
+        // pinnedを破棄した後であればvectorを破棄してよい
+        // (破棄されずに残っている場合は tests/vector_destroy_pinned.cc)
+        std::unique_ptr<y3c::vector<int>> v(new y3c::vector<int>{1, 2, 3});
+        {
+            auto p = v->pin();
+            auto p2 = std::move(p);
+            CHECK_EQ(p2[0], 1);
+        }
+        v.reset();
+        CHECK_FALSE(v);
+    }
+
+}
+
+TEST_CASE("vector soak") {
+    y3c::internal::throw_on_terminate = true;
+
+    // イテレータの生成や要素の変更を繰り返しても、
+    // ライフタイムの管理情報が増え続けないことを確認する
+    y3c::vector<int> a(100);
+    a.reserve(200);
+    SUBCASE("iterate") {
+        auto first = a.begin();
+        for (int n = 0; n < 1000000; n++) {
+            auto it = a.begin() + (n % 100);
+            *it = n;
+        }
+        CHECK_EQ(first.get_observer_().invalidations_size(), 0);
+    }
+    SUBCASE("push_back and pop_back") {
+        auto first = a.begin();
+        for (int n = 0; n < 1000000; n++) {
+            a.push_back(n);
+            a.pop_back();
+        }
+        CHECK_LE(first.get_observer_().invalidations_size(), 1);
+        CHECK_EQ(unwrap(first), &unwrap(a[0]));
+        CHECK_EQ(unwrap(*first), 0);
+    }
+    SUBCASE("erase near the end") {
+        std::vector<y3c::vector<int>::iterator> front;
+        for (int i = 0; i < 50; i++) {
+            front.push_back(a.begin() + i);
+        }
+        auto last = a.end() - 1;
+        for (int n = 0; n < 100000; n++) {
+            a.insert(a.end() - 1, n);
+            a.erase(a.end() - 2);
+        }
+        CHECK_LE(front[0].get_observer_().invalidations_size(), 1);
+        CHECK_EQ(unwrap(*front[49]), 0);
+        CHECK_THROWS_AS(*last, y3c::internal::ub_invalid_iter);
+    }
+    SUBCASE("take iterator, then mutate") {
+        // 古いイテレータを持ったまま変更のたびにイテレータを作っても、
+        // 記録は残っているイテレータの世代の分しか増えない
+        a.reserve(a.size() + 200000);
+        auto first = a.begin();
+        auto last = a.end() - 1;
+        a.pop_back();
+        for (int n = 0; n < 200000; n++) {
+            a.push_back(n);
+            *(a.end() - 1) = n;
+        }
+        CHECK_LE(first.get_observer_().invalidations_size(), 1);
+        CHECK_EQ(unwrap(*first), 0);
+        CHECK_THROWS_AS(*last, y3c::internal::ub_invalid_iter);
+    }
+    SUBCASE("range, then mutate") {
+        a.reserve(a.size() + 100000);
+        auto first = a.begin();
+        for (int n = 0; n < 100000; n++) {
+            for (int &x : y3c::range(a)) {
+                x = n;
+                break;
+            }
+            a.push_back(n);
+        }
+        CHECK_LE(first.get_observer_().invalidations_size(), 1);
+        CHECK_EQ(unwrap(*first), 99999);
+    }
+    SUBCASE("release observers") {
+        {
+            auto first = a.begin();
+            for (int n = 0; n < 100; n++) {
+                a.push_back(n);
+            }
+            // イテレータを作っていない間の変更は1つの記録にまとまる
+            CHECK_LE(first.get_observer_().invalidations_size(), 1);
+            CHECK_EQ(unwrap(*first), 0);
+        }
+        {
+            auto last = a.end() - 1;
+            for (int n = 0; n < 100; n++) {
+                auto it = a.end() - 1;
+                a.pop_back();
+                CHECK_THROWS_AS(*it, y3c::internal::ub_invalid_iter);
+            }
+            CHECK_LE(a.begin().get_observer_().invalidations_size(), 1);
+            CHECK_THROWS_AS(*last, y3c::internal::ub_invalid_iter);
+        }
+        a.push_back(0);
+        CHECK_EQ(a.begin().get_observer_().invalidations_size(), 0);
+    }
+}
+
+TEST_CASE("vector threads") {
+    y3c::internal::throw_on_terminate = true;
+
+    // 同じvectorを複数のスレッドから読んでもチェック自体がデータ競合しない
+    // (ThreadSanitizerで確認する)
+    const int num_threads = 4;
+    y3c::vector<int> a(1000, 1);
+    const y3c::vector<int> &ca = a;
+    SUBCASE("read") {
+        std::vector<int> sums(num_threads);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; t++) {
+            threads.emplace_back([&, t] {
+                int sum = 0;
+                for (int n = 0; n < 10; n++) {
+                    for (auto it = ca.begin(); it != ca.end(); ++it) {
+                        sum += unwrap(*it);
+                    }
+                    for (std::size_t i = 0; i < ca.size(); i++) {
+                        sum += unwrap(ca[i]);
+                    }
+                }
+                sums[t] = sum;
+            });
+        }
+        for (auto &th : threads) {
+            th.join();
+        }
+        for (int t = 0; t < num_threads; t++) {
+            CHECK_EQ(sums[t], 20000);
+        }
+    }
+    SUBCASE("check after invalidation") {
+        std::vector<y3c::vector<int>::const_iterator> iters;
+        for (int t = 0; t < num_threads; t++) {
+            iters.push_back(ca.begin() + t * 250);
+            iters.push_back(ca.begin() + t * 250 + 249);
+        }
+        a.erase(a.begin() + 500, a.end());
+        // 無効化の記録を各スレッドが同時に参照する
+        std::vector<char> valid(iters.size());
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; t++) {
+            threads.emplace_back([&, t] {
+                for (int i = t * 2; i < t * 2 + 2; i++) {
+                    valid[i] = iters[i].get_observer_().is_valid(
+                        iters[i].get_validator_(), unwrap(iters[i]));
+                }
+            });
+        }
+        for (auto &th : threads) {
+            th.join();
+        }
+        CHECK(valid[0]);
+        CHECK(valid[3]);
+        CHECK_FALSE(valid[4]);
+        CHECK_FALSE(valid[7]);
+    }
+}
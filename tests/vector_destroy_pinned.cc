@@ -0,0 +1,22 @@
+// pin() したままvectorを破棄すると、vectorのデストラクタでterminateする。
+// デストラクタからは throw_on_terminate でも例外を投げないので、
+// doctestではなく abort() されることで確認する。
+#include <y3c/vector.h>
+#include <csignal>
+#include <cstdlib>
+#include <memory>
+
+extern "C" void exit_on_abort(int) { std::_Exit(EXIT_SUCCESS); }
+
+int main() {
+    if (!y3c::internal::check_lifetime) {
+        // 寿命のチェックをしないレベルでは pin() を数えない
+        return EXIT_SUCCESS;
+    }
+    std::signal(SIGABRT, &exit_on_abort);
+    std::unique_ptr<y3c::vector<int>> v(new y3c::vector<int>{1, 2, 3});
+    auto p = v->pin();
+    v.reset();
+    // terminateしなかった
+    return EXIT_FAILURE;
+}